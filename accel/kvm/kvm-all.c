@@ -949,26 +949,28 @@ static bool kvm_slot_get_dirty_log(KVMState *s, KVMSlot *slot)
     return ret == 0;
 }
 
-/* Should be with all slots_lock held for the address spaces. */
-static void kvm_dirty_ring_mark_page(KVMState *s, uint32_t as_id,
-                                     uint32_t slot_id, uint64_t offset)
+/*
+ * Should be with all slots_lock held for the address spaces.  Returns the
+ * slot that a dirty ring entry refers to, or NULL if the slot is gone.
+ */
+static KVMSlot *kvm_dirty_ring_get_slot(KVMState *s, uint32_t as_id,
+                                        uint32_t slot_id)
 {
     KVMMemoryListener *kml;
     KVMSlot *mem;
 
     if (as_id >= s->nr_as) {
-        return;
+        return NULL;
     }
 
     kml = s->as[as_id].ml;
     mem = &kml->slots[slot_id];
 
-    if (!mem->memory_size || offset >=
-        (mem->memory_size / qemu_real_host_page_size())) {
-        return;
+    if (!mem->memory_size) {
+        return NULL;
     }
 
-    set_bit(offset, mem->dirty_bmap);
+    return mem;
 }
 
 static bool dirty_gfn_is_dirtied(struct kvm_dirty_gfn *gfn)
@@ -1010,6 +1012,9 @@ static uint32_t kvm_dirty_ring_reap_one(KVMState *s, CPUState *cpu)
     struct kvm_dirty_gfn *dirty_gfns = cpu->kvm_dirty_gfns, *cur;
     uint32_t ring_size = s->kvm_dirty_ring_size;
     uint32_t count = 0, fetch = cpu->kvm_fetch_index;
+    uint32_t cur_slot = UINT32_MAX;
+    uint64_t slot_npages = 0;
+    KVMSlot *mem = NULL;
 
     /*
      * It's possible that we race with vcpu creation code where the vcpu is
@@ -1028,8 +1033,19 @@ static uint32_t kvm_dirty_ring_reap_one(KVMState *s, CPUState *cpu)
         if (!dirty_gfn_is_dirtied(cur)) {
             break;
         }
-        kvm_dirty_ring_mark_page(s, cur->slot >> 16, cur->slot & 0xffff,
-                                 cur->offset);
+        /*
+         * Consecutive entries are very likely to hit the same slot, so only
+         * redo the slot lookup when the slot changes.
+         */
+        if (cur->slot != cur_slot) {
+            cur_slot = cur->slot;
+            mem = kvm_dirty_ring_get_slot(s, cur_slot >> 16, cur_slot & 0xffff);
+            slot_npages = mem ? mem->memory_size / qemu_real_host_page_size()
+                              : 0;
+        }
+        if (cur->offset < slot_npages) {
+            set_bit(cur->offset, mem->dirty_bmap);
+        }
         dirty_gfn_set_collected(cur);
         trace_kvm_dirty_ring_page(cpu->cpu_index, fetch, cur->offset);
         fetch++;
@@ -1073,8 +1089,10 @@ static uint64_t kvm_dirty_ring_reap_locked(KVMState *s, CPUState* cpu)
 }
 
 /*
- * Currently for simplicity, we must hold BQL before calling this.  We can
- * consider to drop the BQL if we're clear with all the race conditions.
+ * When reaping all vcpus (cpu == NULL) we must hold BQL, so that no vcpu can
+ * be unplugged and have its ring unmapped under our feet.  A vcpu thread
+ * reaping only its own ring does not need BQL: the ring cannot go away while
+ * the vcpu is running, and everything else is serialized by slots_lock.
  */
 static uint64_t kvm_dirty_ring_reap(KVMState *s, CPUState *cpu)
 {
@@ -1684,7 +1702,7 @@ static void kvm_set_phys_mem(KVMMemoryListener *kml,
                  * Not easy.  Let's cross the fingers until it's fixed.
                  */
                 if (kvm_state->kvm_dirty_ring_size) {
-                    kvm_dirty_ring_reap_locked(kvm_state, NULL);
+                    /* The rings were reaped by kvm_region_commit() */
                     if (kvm_state->kvm_dirty_ring_with_bitmap) {
                         kvm_slot_sync_dirty_pages(mem);
                         kvm_slot_get_dirty_log(kvm_state, mem);
@@ -1928,6 +1946,16 @@ static void kvm_region_commit(MemoryListener *listener)
         accel_ioctl_inhibit_begin();
     }
 
+    /*
+     * Collect the dirty rings once for the whole transaction rather than
+     * once for each removed memslot; removing thousands of slots (e.g. on
+     * virtio-mem unplug) would otherwise walk every vcpu ring each time.
+     */
+    if (kvm_state->kvm_dirty_ring_size &&
+        !QSIMPLEQ_EMPTY(&kml->transaction_del)) {
+        kvm_dirty_ring_reap_locked(kvm_state, NULL);
+    }
+
     /* Remove all memslots before adding the new ones. */
     while (!QSIMPLEQ_EMPTY(&kml->transaction_del)) {
         u1 = QSIMPLEQ_FIRST(&kml->transaction_del);
@@ -3546,19 +3574,15 @@ int kvm_cpu_exec(CPUState *cpu)
              * still full.  Got kicked by KVM_RESET_DIRTY_RINGS.
              */
             trace_kvm_dirty_ring_full(cpu->cpu_index);
-            bql_lock();
             /*
-             * We throttle vCPU by making it sleep once it exit from kernel
-             * due to dirty ring full. In the dirtylimit scenario, reaping
-             * all vCPUs after a single vCPU dirty ring get full result in
-             * the miss of sleep, so just reap the ring-fulled vCPU.
+             * Only reap the ring-fulled vCPU, which can be done without
+             * BQL.  Reaping all vCPUs here would serialize every ring-full
+             * exit behind BQL and a walk of all the rings; the other vCPUs
+             * reap their own rings when they fill up, and the reaper thread
+             * collects the rest periodically.  This also makes sure that
+             * dirtylimit sleeps the vCPU that actually dirtied the memory.
              */
-            if (dirtylimit_in_service()) {
-                kvm_dirty_ring_reap(kvm_state, cpu);
-            } else {
-                kvm_dirty_ring_reap(kvm_state, NULL);
-            }
-            bql_unlock();
+            kvm_dirty_ring_reap(kvm_state, cpu);
             dirtylimit_vcpu_execute(cpu);
             ret = 0;
             break;
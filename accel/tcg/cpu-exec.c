@@ -248,10 +248,12 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, TCGTBCPUState s)
         goto hit;
     }
 
+    qatomic_set(&jc->misses, jc->misses + 1);
     tb = tb_htable_lookup(cpu, s);
     if (tb == NULL) {
         return NULL;
     }
+    qatomic_set(&jc->fills, jc->fills + 1);
 
     jc->array[hash].pc = s.pc;
     qatomic_set(&jc->array[hash].tb, tb);
@@ -265,6 +267,31 @@ hit:
     return tb;
 }
 
+/*
+ * Translate the block described by @s after a tb_lookup() miss.
+ *
+ * In user mode translation is serialized by mmap_lock, so threads running
+ * the same cold code queue up behind whichever one started translating it
+ * first.  Look the block up again once the lock is held, and pick up the
+ * other thread's translation instead of generating a copy that
+ * tb_link_page() would only discard.
+ */
+static TranslationBlock *tb_lookup_or_gen_code(CPUState *cpu,
+                                               TCGTBCPUState s)
+{
+    TranslationBlock *tb = NULL;
+
+    mmap_lock();
+#ifdef CONFIG_USER_ONLY
+    tb = tb_htable_lookup(cpu, s);
+#endif
+    if (tb == NULL) {
+        tb = tb_gen_code(cpu, s);
+    }
+    mmap_unlock();
+    return tb;
+}
+
 static void log_cpu_exec(vaddr pc, CPUState *cpu,
                          const TranslationBlock *tb)
 {
@@ -969,9 +996,7 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 CPUJumpCache *jc;
                 uint32_t h;
 
-                mmap_lock();
-                tb = tb_gen_code(cpu, s);
-                mmap_unlock();
+                tb = tb_lookup_or_gen_code(cpu, s);
 
                 /*
                  * We add the TB in the virtual pc hash table
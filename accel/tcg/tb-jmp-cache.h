@@ -24,6 +24,12 @@
  */
 typedef struct CPUJumpCache {
     struct rcu_head rcu;
+    /*
+     * Lookup statistics, written only by the owning CPU and only on a
+     * miss, so that the hit path stays free of stores.
+     */
+    size_t misses;      /* lookups that missed the cache */
+    size_t fills;       /* misses resolved from the TB hash table */
     struct {
         TranslationBlock *tb;
         vaddr pc;
@@ -16,6 +16,7 @@
 #include "tcg/tcg.h"
 #include "internal-common.h"
 #include "tb-context.h"
+#include "tb-jmp-cache.h"
 #include <math.h>
 
 static void dump_drift_info(GString *buf)
@@ -147,6 +148,23 @@ static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide)
     *pelide = elide;
 }
 
+static void jmp_cache_counts(size_t *pmisses, size_t *pfills)
+{
+    CPUState *cpu;
+    size_t misses = 0, fills = 0;
+
+    CPU_FOREACH(cpu) {
+        CPUJumpCache *jc = cpu->tb_jmp_cache;
+
+        if (jc) {
+            misses += qatomic_read(&jc->misses);
+            fills += qatomic_read(&jc->fills);
+        }
+    }
+    *pmisses = misses;
+    *pfills = fills;
+}
+
 static void tcg_dump_flush_info(GString *buf)
 {
     size_t flush_full, flush_part, flush_elide;
@@ -162,6 +180,16 @@ static void tcg_dump_flush_info(GString *buf)
     g_string_append_printf(buf, "TLB elided flushes  %zu\n", flush_elide);
 }
 
+static void tcg_dump_jmp_cache_info(GString *buf)
+{
+    size_t misses, fills;
+
+    jmp_cache_counts(&misses, &fills);
+    g_string_append_printf(buf, "TB jmp cache misses %zu\n", misses);
+    g_string_append_printf(buf, "TB jmp cache fills  %zu (%zu%% of misses)\n",
+                           fills, misses ? fills * 100 / misses : 0);
+}
+
 static void dump_exec_info(GString *buf)
 {
     struct tb_tree_stats tst = {};
@@ -204,6 +232,7 @@ static void dump_exec_info(GString *buf)
 
     g_string_append_printf(buf, "\nStatistics:\n");
     tcg_dump_flush_info(buf);
+    tcg_dump_jmp_cache_info(buf);
 }
 
 void tcg_get_stats(AccelState *accel, GString *buf)
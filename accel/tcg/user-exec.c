@@ -168,6 +168,49 @@ typedef struct PageFlagsNode {
 
 static IntervalTreeRoot pageflags_root;
 
+/*
+ * Bumped after every change to pageflags_root.  Each thread remembers the
+ * last node it found in page_get_flags() or page_check_range() together
+ * with the generation it was found in, so that repeated lookups in the
+ * same mapping skip the tree walk until the next change.  Generation 0
+ * marks the cache as invalid.
+ */
+static uint64_t pageflags_gen = 1;
+
+typedef struct PageFlagsCache {
+    uint64_t gen;
+    vaddr start;
+    vaddr last;
+    int flags;
+} PageFlagsCache;
+
+static __thread PageFlagsCache pageflags_cache;
+
+static const PageFlagsCache *pageflags_cache_find(vaddr start, vaddr last)
+{
+    const PageFlagsCache *c = &pageflags_cache;
+
+    if (c->gen == qatomic_read(&pageflags_gen) &&
+        start >= c->start && last <= c->last) {
+        return c;
+    }
+    return NULL;
+}
+
+static void pageflags_cache_fill(uint64_t gen, const PageFlagsNode *p)
+{
+    PageFlagsCache *c = &pageflags_cache;
+
+    /* Lookups may happen from a signal handler on this thread.  */
+    c->gen = 0;
+    barrier();
+    c->start = p->itree.start;
+    c->last = p->itree.last;
+    c->flags = p->flags;
+    barrier();
+    c->gen = gen;
+}
+
 static PageFlagsNode *pageflags_find(vaddr start, vaddr last)
 {
     IntervalTreeNode *n;
@@ -239,7 +282,14 @@ void page_dump(FILE *f)
 
 int page_get_flags(vaddr address)
 {
+    const PageFlagsCache *c;
     PageFlagsNode *p;
+    uint64_t gen;
+
+    c = pageflags_cache_find(address, address);
+    if (c) {
+        return c->flags;
+    }
 
     RCU_READ_LOCK_GUARD();
 
@@ -248,8 +298,10 @@ int page_get_flags(vaddr address)
      * there are false negatives.  If we find nothing, retry with the mmap
      * lock acquired.
      */
+    gen = qatomic_load_acquire(&pageflags_gen);
     p = pageflags_find(address, address);
     if (p) {
+        pageflags_cache_fill(gen, p);
         return p->flags;
     }
     if (have_mmap_lock()) {
@@ -456,6 +508,8 @@ static bool pageflags_set_clear(vaddr start, vaddr last,
     }
 
  done:
+    /* Invalidate the lookup caches of all threads */
+    qatomic_inc(&pageflags_gen);
     return inval_tb;
 }
 
@@ -495,6 +549,8 @@ void page_set_flags(vaddr start, vaddr last, int set_flags, int clear_flags)
 
 bool page_check_range(vaddr start, vaddr len, int flags)
 {
+    const PageFlagsCache *c;
+    uint64_t gen;
     vaddr last;
     int locked;  /* tri-state: =0: unlocked, +1: global, -1: local */
     bool ret;
@@ -508,14 +564,22 @@ bool page_check_range(vaddr start, vaddr len, int flags)
         return false; /* wrap around */
     }
 
+    c = pageflags_cache_find(start, last);
+    if (c && !(flags & ~c->flags)) {
+        return true;
+    }
+
     RCU_READ_LOCK_GUARD();
 
+    gen = qatomic_load_acquire(&pageflags_gen);
     locked = have_mmap_lock();
     while (true) {
         PageFlagsNode *p = pageflags_find(start, last);
         int missing;
 
-        if (!p) {
+        if (p) {
+            pageflags_cache_fill(gen, p);
+        } else {
             if (!locked) {
                 /*
                  * Lockless lookups have false negatives.
@@ -20,8 +20,10 @@
 
 #include "qemu/osdep.h"
 
+#include "block/aio_task.h"
 #include "block/block_int.h"
 #include "block/qdict.h"
+#include "block/thread-pool.h"
 #include "system/block-backend.h"
 #include "crypto/block.h"
 #include "qapi/opts-visitor.h"
@@ -480,131 +482,249 @@ static int block_crypto_reopen_prepare(BDRVReopenState *state,
  */
 #define BLOCK_CRYPTO_MAX_IO_SIZE (1024 * 1024)
 
+/*
+ * Number of chunks of a large request that are processed in parallel, each
+ * with its own bounce buffer.
+ */
+#define BLOCK_CRYPTO_MAX_WORKERS 4
+
+typedef int (*BlockCryptoEncDecFunc)(QCryptoBlock *block, uint64_t offset,
+                                     uint8_t *buf, size_t len, Error **errp);
+
+typedef struct BlockCryptoEncDecData {
+    QCryptoBlock *block;
+    uint64_t offset;
+    uint8_t *buf;
+    size_t len;
+
+    BlockCryptoEncDecFunc func;
+} BlockCryptoEncDecData;
+
+static int block_crypto_encdec_pool_func(void *opaque)
+{
+    BlockCryptoEncDecData *data = opaque;
+
+    return data->func(data->block, data->offset, data->buf, data->len, NULL);
+}
+
+/*
+ * Encrypt or decrypt @buf in place.  When @offload is true the work is done
+ * in the thread pool, so that the chunks of a large request are processed
+ * in parallel and overlap with the I/O of the other chunks.  Small requests
+ * are handled inline to avoid the thread pool round trip.
+ */
+static int coroutine_fn
+block_crypto_co_encdec(BlockCrypto *crypto, bool offload, uint64_t offset,
+                       uint8_t *buf, size_t len, BlockCryptoEncDecFunc func)
+{
+    BlockCryptoEncDecData arg = {
+        .block = crypto->block,
+        .offset = offset,
+        .buf = buf,
+        .len = len,
+        .func = func,
+    };
+    int ret;
+
+    if (offload) {
+        ret = thread_pool_submit_co(block_crypto_encdec_pool_func, &arg);
+    } else {
+        ret = block_crypto_encdec_pool_func(&arg);
+    }
+
+    return ret < 0 ? -EIO : 0;
+}
+
+typedef struct BlockCryptoAioTask {
+    AioTask task;
+
+    BlockDriverState *bs;
+    uint64_t offset;
+    uint64_t bytes;
+    QEMUIOVector *qiov;
+    size_t qiov_offset;
+    BdrvRequestFlags flags;
+} BlockCryptoAioTask;
+
+static coroutine_fn int block_crypto_add_task(BlockDriverState *bs,
+                                              AioTaskPool *pool,
+                                              AioTaskFunc func,
+                                              uint64_t offset,
+                                              uint64_t bytes,
+                                              QEMUIOVector *qiov,
+                                              size_t qiov_offset,
+                                              BdrvRequestFlags flags)
+{
+    BlockCryptoAioTask local_task;
+    BlockCryptoAioTask *task = pool ? g_new(BlockCryptoAioTask, 1) :
+                                      &local_task;
+
+    *task = (BlockCryptoAioTask) {
+        .task.func = func,
+        .bs = bs,
+        .offset = offset,
+        .bytes = bytes,
+        .qiov = qiov,
+        .qiov_offset = qiov_offset,
+        .flags = flags,
+    };
+
+    if (!pool) {
+        return func(&task->task);
+    }
+
+    aio_task_pool_start_task(pool, &task->task);
+
+    return 0;
+}
+
+/*
+ * These functions can count as GRAPH_RDLOCK because block_crypto_co_preadv()
+ * and block_crypto_co_pwritev() hold the graph lock and keep it until all
+ * their tasks have terminated.
+ */
 static int coroutine_fn GRAPH_RDLOCK
-block_crypto_co_preadv(BlockDriverState *bs, int64_t offset, int64_t bytes,
-                       QEMUIOVector *qiov, BdrvRequestFlags flags)
+block_crypto_co_preadv_task_entry(AioTask *task)
 {
+    BlockCryptoAioTask *t = container_of(task, BlockCryptoAioTask, task);
+    BlockDriverState *bs = t->bs;
     BlockCrypto *crypto = bs->opaque;
-    uint64_t cur_bytes; /* number of bytes in current iteration */
-    uint64_t bytes_done = 0;
-    uint8_t *cipher_data = NULL;
-    QEMUIOVector hd_qiov;
-    int ret = 0;
-    uint64_t sector_size = qcrypto_block_get_sector_size(crypto->block);
     uint64_t payload_offset = qcrypto_block_get_payload_offset(crypto->block);
-
-    assert(payload_offset < INT64_MAX);
-    assert(QEMU_IS_ALIGNED(offset, sector_size));
-    assert(QEMU_IS_ALIGNED(bytes, sector_size));
-
-    qemu_iovec_init(&hd_qiov, qiov->niov);
+    uint8_t *cipher_data;
+    int ret;
 
     /* Bounce buffer because we don't wish to expose cipher text
      * in qiov which points to guest memory.
      */
-    cipher_data =
-        qemu_try_blockalign(bs->file->bs, MIN(BLOCK_CRYPTO_MAX_IO_SIZE,
-                                              qiov->size));
+    cipher_data = qemu_try_blockalign(bs->file->bs, t->bytes);
     if (cipher_data == NULL) {
-        ret = -ENOMEM;
-        goto cleanup;
+        return -ENOMEM;
     }
 
-    while (bytes) {
-        cur_bytes = MIN(bytes, BLOCK_CRYPTO_MAX_IO_SIZE);
+    ret = bdrv_co_pread(bs->file, payload_offset + t->offset, t->bytes,
+                        cipher_data, 0);
+    if (ret < 0) {
+        goto out;
+    }
 
-        qemu_iovec_reset(&hd_qiov);
-        qemu_iovec_add(&hd_qiov, cipher_data, cur_bytes);
+    ret = block_crypto_co_encdec(crypto, task->pool, t->offset, cipher_data,
+                                 t->bytes, qcrypto_block_decrypt);
+    if (ret < 0) {
+        goto out;
+    }
 
-        ret = bdrv_co_preadv(bs->file, payload_offset + offset + bytes_done,
-                             cur_bytes, &hd_qiov, 0);
-        if (ret < 0) {
-            goto cleanup;
-        }
+    qemu_iovec_from_buf(t->qiov, t->qiov_offset, cipher_data, t->bytes);
 
-        if (qcrypto_block_decrypt(crypto->block, offset + bytes_done,
-                                  cipher_data, cur_bytes, NULL) < 0) {
-            ret = -EIO;
-            goto cleanup;
-        }
+ out:
+    qemu_vfree(cipher_data);
+    return ret;
+}
 
-        qemu_iovec_from_buf(qiov, bytes_done, cipher_data, cur_bytes);
+static int coroutine_fn GRAPH_RDLOCK
+block_crypto_co_pwritev_task_entry(AioTask *task)
+{
+    BlockCryptoAioTask *t = container_of(task, BlockCryptoAioTask, task);
+    BlockDriverState *bs = t->bs;
+    BlockCrypto *crypto = bs->opaque;
+    uint64_t payload_offset = qcrypto_block_get_payload_offset(crypto->block);
+    uint8_t *cipher_data;
+    int ret;
 
-        bytes -= cur_bytes;
-        bytes_done += cur_bytes;
+    /* Bounce buffer because we're not permitted to touch
+     * contents of qiov - it points to guest memory.
+     */
+    cipher_data = qemu_try_blockalign(bs->file->bs, t->bytes);
+    if (cipher_data == NULL) {
+        return -ENOMEM;
     }
 
- cleanup:
-    qemu_iovec_destroy(&hd_qiov);
-    qemu_vfree(cipher_data);
+    qemu_iovec_to_buf(t->qiov, t->qiov_offset, cipher_data, t->bytes);
 
+    ret = block_crypto_co_encdec(crypto, task->pool, t->offset, cipher_data,
+                                 t->bytes, qcrypto_block_encrypt);
+    if (ret < 0) {
+        goto out;
+    }
+
+    ret = bdrv_co_pwrite(bs->file, payload_offset + t->offset, t->bytes,
+                         cipher_data, t->flags);
+
+ out:
+    qemu_vfree(cipher_data);
     return ret;
 }
 
-
+/*
+ * Split the request into BLOCK_CRYPTO_MAX_IO_SIZE chunks.  If there is more
+ * than one chunk, up to BLOCK_CRYPTO_MAX_WORKERS of them are in flight at
+ * the same time.
+ */
 static int coroutine_fn GRAPH_RDLOCK
-block_crypto_co_pwritev(BlockDriverState *bs, int64_t offset, int64_t bytes,
-                        QEMUIOVector *qiov, BdrvRequestFlags flags)
+block_crypto_co_rw(BlockDriverState *bs, int64_t offset, int64_t bytes,
+                   QEMUIOVector *qiov, BdrvRequestFlags flags,
+                   AioTaskFunc func)
 {
     BlockCrypto *crypto = bs->opaque;
     uint64_t cur_bytes; /* number of bytes in current iteration */
-    uint64_t bytes_done = 0;
-    uint8_t *cipher_data = NULL;
-    QEMUIOVector hd_qiov;
+    size_t qiov_offset = 0;
+    AioTaskPool *aio = NULL;
     int ret = 0;
     uint64_t sector_size = qcrypto_block_get_sector_size(crypto->block);
     uint64_t payload_offset = qcrypto_block_get_payload_offset(crypto->block);
 
-    flags &= ~BDRV_REQ_REGISTERED_BUF;
-
     assert(payload_offset < INT64_MAX);
     assert(QEMU_IS_ALIGNED(offset, sector_size));
     assert(QEMU_IS_ALIGNED(bytes, sector_size));
 
-    qemu_iovec_init(&hd_qiov, qiov->niov);
-
-    /* Bounce buffer because we're not permitted to touch
-     * contents of qiov - it points to guest memory.
-     */
-    cipher_data =
-        qemu_try_blockalign(bs->file->bs, MIN(BLOCK_CRYPTO_MAX_IO_SIZE,
-                                              qiov->size));
-    if (cipher_data == NULL) {
-        ret = -ENOMEM;
-        goto cleanup;
-    }
-
-    while (bytes) {
+    while (bytes && aio_task_pool_status(aio) == 0) {
         cur_bytes = MIN(bytes, BLOCK_CRYPTO_MAX_IO_SIZE);
 
-        qemu_iovec_to_buf(qiov, bytes_done, cipher_data, cur_bytes);
-
-        if (qcrypto_block_encrypt(crypto->block, offset + bytes_done,
-                                  cipher_data, cur_bytes, NULL) < 0) {
-            ret = -EIO;
-            goto cleanup;
+        if (!aio && cur_bytes != bytes) {
+            aio = aio_task_pool_new(BLOCK_CRYPTO_MAX_WORKERS);
         }
 
-        qemu_iovec_reset(&hd_qiov);
-        qemu_iovec_add(&hd_qiov, cipher_data, cur_bytes);
-
-        ret = bdrv_co_pwritev(bs->file, payload_offset + offset + bytes_done,
-                              cur_bytes, &hd_qiov, flags);
+        ret = block_crypto_add_task(bs, aio, func, offset, cur_bytes,
+                                    qiov, qiov_offset, flags);
         if (ret < 0) {
-            goto cleanup;
+            goto out;
         }
 
         bytes -= cur_bytes;
-        bytes_done += cur_bytes;
+        offset += cur_bytes;
+        qiov_offset += cur_bytes;
     }
 
- cleanup:
-    qemu_iovec_destroy(&hd_qiov);
-    qemu_vfree(cipher_data);
+ out:
+    if (aio) {
+        aio_task_pool_wait_all(aio);
+        if (ret == 0) {
+            ret = aio_task_pool_status(aio);
+        }
+        g_free(aio);
+    }
 
     return ret;
 }
 
+static int coroutine_fn GRAPH_RDLOCK
+block_crypto_co_preadv(BlockDriverState *bs, int64_t offset, int64_t bytes,
+                       QEMUIOVector *qiov, BdrvRequestFlags flags)
+{
+    return block_crypto_co_rw(bs, offset, bytes, qiov, 0,
+                              block_crypto_co_preadv_task_entry);
+}
+
+
+static int coroutine_fn GRAPH_RDLOCK
+block_crypto_co_pwritev(BlockDriverState *bs, int64_t offset, int64_t bytes,
+                        QEMUIOVector *qiov, BdrvRequestFlags flags)
+{
+    flags &= ~BDRV_REQ_REGISTERED_BUF;
+
+    return block_crypto_co_rw(bs, offset, bytes, qiov, flags,
+                              block_crypto_co_pwritev_task_entry);
+}
+
 static void block_crypto_refresh_limits(BlockDriverState *bs, Error **errp)
 {
     BlockCrypto *crypto = bs->opaque;
@@ -87,6 +87,12 @@ typedef struct MirrorBlockJob {
     QTAILQ_HEAD(, MirrorOp) ops_in_flight;
     int ret;
     bool unmap;
+    /*
+     * Try to offload copies with copy_range; cleared once copy_range turns
+     * out not to be supported, after which all copies go through the
+     * bounce buffers.
+     */
+    bool use_copy_range;
     int target_cluster_size;
     int max_iov;
     bool initial_zeroing_ongoing;
@@ -379,6 +385,42 @@ static void coroutine_fn mirror_co_read(void *opaque)
     assert(QEMU_IS_ALIGNED(op->bytes, BDRV_SECTOR_SIZE));
     nb_chunks = DIV_ROUND_UP(op->bytes, s->granularity);
 
+    if (s->use_copy_range) {
+        /*
+         * An offloaded copy (e.g. copy_file_range() or a reflink within the
+         * same filesystem) does not need a bounce buffer.
+         */
+        s->in_flight++;
+        s->bytes_in_flight += op->bytes;
+        op->is_in_flight = true;
+        trace_mirror_one_iteration(s, op->offset, op->bytes);
+
+        WITH_GRAPH_RDLOCK_GUARD() {
+            ret = blk_co_copy_range_from(s->mirror_top_bs->backing,
+                                         op->offset, s->target, op->offset,
+                                         op->bytes, 0, 0);
+        }
+        if (ret != -ENOTSUP && ret != -EINVAL && ret != -EXDEV) {
+            /*
+             * Success, or a real I/O error.  copy_range does not tell
+             * whether the source or the target failed; the write is the
+             * more likely culprit, so apply the target error action.
+             */
+            mirror_write_complete(op, ret);
+            return;
+        }
+
+        /*
+         * copy_range is not supported for this configuration.  Don't try
+         * again, and retry this request with read and write.
+         */
+        trace_mirror_copy_range_fail(s, op->offset, ret);
+        s->use_copy_range = false;
+        s->in_flight--;
+        s->bytes_in_flight -= op->bytes;
+        op->is_in_flight = false;
+    }
+
     while (s->buf_free_count < nb_chunks) {
         trace_mirror_yield_in_flight(s, op->offset, s->in_flight);
         mirror_wait_for_free_in_flight_slot(s);
@@ -1846,7 +1888,7 @@ static BlockJob *mirror_start_job(
                              BlockDriverState *base,
                              bool auto_complete, const char *filter_node_name,
                              bool is_mirror, MirrorCopyMode copy_mode,
-                             bool base_ro,
+                             bool base_ro, bool use_copy_range,
                              Error **errp)
 {
     MirrorBlockJob *s;
@@ -2008,6 +2050,7 @@ static BlockJob *mirror_start_job(
     if (ret < 0) {
         goto fail;
     }
+    s->use_copy_range = use_copy_range;
     if (is_mirror) {
         /* XXX: Mirror target could be a NBD server of target QEMU in the case
          * of non-shared block migration. To allow migration completion, we
@@ -2146,7 +2189,8 @@ void mirror_start(const char *job_id, BlockDriverState *bs,
                   BlockdevOnError on_source_error,
                   BlockdevOnError on_target_error,
                   bool unmap, const char *filter_node_name,
-                  MirrorCopyMode copy_mode, Error **errp)
+                  MirrorCopyMode copy_mode, bool use_copy_range,
+                  Error **errp)
 {
     BlockDriverState *base;
 
@@ -2167,7 +2211,8 @@ void mirror_start(const char *job_id, BlockDriverState *bs,
                      speed, granularity, buf_size, mode, backing_mode,
                      target_is_zero, on_source_error, on_target_error, unmap,
                      NULL, NULL, &mirror_job_driver, base, false,
-                     filter_node_name, true, copy_mode, false, errp);
+                     filter_node_name, true, copy_mode, false,
+                     use_copy_range, errp);
 }
 
 BlockJob *commit_active_start(const char *job_id, BlockDriverState *bs,
@@ -2196,7 +2241,7 @@ BlockJob *commit_active_start(const char *job_id, BlockDriverState *bs,
                      on_error, on_error, true, cb, opaque,
                      &commit_active_job_driver, base, auto_complete,
                      filter_node_name, false, MIRROR_COPY_MODE_BACKGROUND,
-                     base_read_only, errp);
+                     base_read_only, false, errp);
     if (!job) {
         goto error_restore_flags;
     }
@@ -24,6 +24,7 @@
 
 #include "qemu/osdep.h"
 #include "block/block-io.h"
+#include "block/aio_task.h"
 #include "qapi/error.h"
 #include "qcow2.h"
 #include "qemu/range.h"
@@ -889,14 +890,15 @@ update_refcount(BlockDriverState *bs, int64_t offset, int64_t length,
             void *table;
 
             table = qcow2_cache_is_table_offset(s->refcount_block_cache,
-                                                offset);
+                                                cluster_offset);
             if (table != NULL) {
                 qcow2_cache_put(s->refcount_block_cache, &refcount_block);
                 old_table_index = -1;
                 qcow2_cache_discard(s->refcount_block_cache, table);
             }
 
-            table = qcow2_cache_is_table_offset(s->l2_table_cache, offset);
+            table = qcow2_cache_is_table_offset(s->l2_table_cache,
+                                                cluster_offset);
             if (table != NULL) {
                 qcow2_cache_discard(s->l2_table_cache, table);
             }
@@ -1257,6 +1259,84 @@ int qcow2_flush_caches(BlockDriverState *bs)
 
 
 
+/*
+ * Apply @addend to the refcounts of all clusters referenced by one L2 slice.
+ *
+ * Runs of physically contiguous data clusters are passed to update_refcount()
+ * as a single range, so that each refcount block is looked up once per run
+ * rather than once per cluster.  Sequentially written images consist almost
+ * entirely of such runs.
+ */
+static int GRAPH_RDLOCK
+update_snapshot_refcount_slice(BlockDriverState *bs, uint64_t *l2_slice,
+                               uint64_t l2_offset, unsigned slice, int addend)
+{
+    BDRVQcow2State *s = bs->opaque;
+    uint64_t run_start = 0, run_len = 0;
+    int j, ret;
+
+    for (j = 0; j < s->l2_slice_size; j++) {
+        uint64_t entry = get_l2_entry(s, l2_slice, j) & ~QCOW_OFLAG_COPIED;
+        uint64_t offset = entry & L2E_OFFSET_MASK;
+
+        switch (qcow2_get_cluster_type(bs, entry)) {
+        case QCOW2_CLUSTER_COMPRESSED:
+            if (addend != 0) {
+                uint64_t coffset;
+                int csize;
+
+                qcow2_parse_compressed_l2_entry(bs, entry, &coffset, &csize);
+                ret = update_refcount(bs, coffset, csize, abs(addend),
+                                      addend < 0, QCOW2_DISCARD_SNAPSHOT);
+                if (ret < 0) {
+                    return ret;
+                }
+            }
+            break;
+
+        case QCOW2_CLUSTER_NORMAL:
+        case QCOW2_CLUSTER_ZERO_ALLOC:
+            if (offset_into_cluster(s, offset)) {
+                /* Here l2_index means table (not slice) index */
+                int l2_index = slice * s->l2_slice_size + j;
+                qcow2_signal_corruption(bs, true, -1, -1, "Cluster "
+                                        "allocation offset %#" PRIx64
+                                        " unaligned (L2 offset: %#"
+                                        PRIx64 ", L2 index: %#x)",
+                                        offset, l2_offset, l2_index);
+                return -EIO;
+            }
+            assert(offset >> s->cluster_bits);
+
+            if (addend == 0) {
+                break;
+            }
+            if (run_len && offset == run_start + run_len) {
+                run_len += s->cluster_size;
+                break;
+            }
+            ret = update_refcount(bs, run_start, run_len, abs(addend),
+                                  addend < 0, QCOW2_DISCARD_SNAPSHOT);
+            if (ret < 0) {
+                return ret;
+            }
+            run_start = offset;
+            run_len = s->cluster_size;
+            break;
+
+        case QCOW2_CLUSTER_ZERO_PLAIN:
+        case QCOW2_CLUSTER_UNALLOCATED:
+            break;
+
+        default:
+            abort();
+        }
+    }
+
+    return update_refcount(bs, run_start, run_len, abs(addend), addend < 0,
+                           QCOW2_DISCARD_SNAPSHOT);
+}
+
 /* update the refcounts of snapshots and the copied flag */
 int qcow2_update_snapshot_refcount(BlockDriverState *bs,
     int64_t l1_table_offset, int l1_size, int addend)
@@ -1326,6 +1406,12 @@ int qcow2_update_snapshot_refcount(BlockDriverState *bs,
                     goto fail;
                 }
 
+                ret = update_snapshot_refcount_slice(bs, l2_slice, l2_offset,
+                                                     slice, addend);
+                if (ret < 0) {
+                    goto fail;
+                }
+
                 for (j = 0; j < s->l2_slice_size; j++) {
                     uint64_t cluster_index;
                     uint64_t offset;
@@ -1337,50 +1423,14 @@ int qcow2_update_snapshot_refcount(BlockDriverState *bs,
 
                     switch (qcow2_get_cluster_type(bs, entry)) {
                     case QCOW2_CLUSTER_COMPRESSED:
-                        if (addend != 0) {
-                            uint64_t coffset;
-                            int csize;
-
-                            qcow2_parse_compressed_l2_entry(bs, entry,
-                                                            &coffset, &csize);
-                            ret = update_refcount(
-                                bs, coffset, csize,
-                                abs(addend), addend < 0,
-                                QCOW2_DISCARD_SNAPSHOT);
-                            if (ret < 0) {
-                                goto fail;
-                            }
-                        }
                         /* compressed clusters are never modified */
                         refcount = 2;
                         break;
 
                     case QCOW2_CLUSTER_NORMAL:
                     case QCOW2_CLUSTER_ZERO_ALLOC:
-                        if (offset_into_cluster(s, offset)) {
-                            /* Here l2_index means table (not slice) index */
-                            int l2_index = slice * s->l2_slice_size + j;
-                            qcow2_signal_corruption(
-                                bs, true, -1, -1, "Cluster "
-                                "allocation offset %#" PRIx64
-                                " unaligned (L2 offset: %#"
-                                PRIx64 ", L2 index: %#x)",
-                                offset, l2_offset, l2_index);
-                            ret = -EIO;
-                            goto fail;
-                        }
-
+                        /* Refcount already updated (and offset checked) */
                         cluster_index = offset >> s->cluster_bits;
-                        assert(cluster_index);
-                        if (addend != 0) {
-                            ret = qcow2_update_cluster_refcount(
-                                bs, cluster_index, abs(addend), addend < 0,
-                                QCOW2_DISCARD_SNAPSHOT);
-                            if (ret < 0) {
-                                goto fail;
-                            }
-                        }
-
                         ret = qcow2_get_refcount(bs, cluster_index, &refcount);
                         if (ret < 0) {
                             goto fail;
@@ -1670,8 +1720,8 @@ fail:
 
 /*
  * Increases the refcount in the given refcount table for the all clusters
- * referenced in the L2 table. While doing so, performs some checks on L2
- * entries.
+ * referenced in the L2 table @l2_table, which has been read from @l2_offset.
+ * While doing so, performs some checks on L2 entries.
  *
  * Returns the number of errors found by the checks or -errno if an internal
  * error occurred.
@@ -1680,24 +1730,15 @@ static int coroutine_fn GRAPH_RDLOCK
 check_refcounts_l2(BlockDriverState *bs, BdrvCheckResult *res,
                    void **refcount_table,
                    int64_t *refcount_table_size, int64_t l2_offset,
+                   uint64_t *l2_table,
                    int flags, BdrvCheckMode fix, bool active)
 {
     BDRVQcow2State *s = bs->opaque;
     uint64_t l2_entry, l2_bitmap;
     uint64_t next_contiguous_offset = 0;
     int i, ret;
-    size_t l2_size_bytes = s->l2_size * l2_entry_size(s);
-    g_autofree uint64_t *l2_table = g_malloc(l2_size_bytes);
     bool metadata_overlap;
 
-    /* Read L2 table from disk */
-    ret = bdrv_co_pread(bs->file, l2_offset, l2_size_bytes, l2_table, 0);
-    if (ret < 0) {
-        fprintf(stderr, "ERROR: I/O error in check_refcounts_l2\n");
-        res->check_errors++;
-        return ret;
-    }
-
     /* Do the actual checks */
     for (i = 0; i < s->l2_size; i++) {
         uint64_t coffset;
@@ -1868,11 +1909,38 @@ check_refcounts_l2(BlockDriverState *bs, BdrvCheckResult *res,
     return 0;
 }
 
+typedef struct Qcow2CheckL2ReadTask {
+    AioTask task;
+    BlockDriverState *bs;
+    uint64_t l2_offset;
+    uint64_t *l2_table;
+    int *ret;
+} Qcow2CheckL2ReadTask;
+
+static int coroutine_fn GRAPH_RDLOCK
+check_refcounts_l2_read_task_entry(AioTask *task)
+{
+    Qcow2CheckL2ReadTask *t = container_of(task, Qcow2CheckL2ReadTask, task);
+    BDRVQcow2State *s = t->bs->opaque;
+
+    /*
+     * Errors are reported per table by check_refcounts_l1(), in L1 order, so
+     * do not fail the whole pool here.
+     */
+    *t->ret = bdrv_co_pread(t->bs->file, t->l2_offset,
+                            s->l2_size * l2_entry_size(s), t->l2_table, 0);
+    return 0;
+}
+
 /*
  * Increases the refcount for the L1 table, its L2 tables and all referenced
  * clusters in the given refcount table. While doing so, performs some checks
  * on L1 and L2 entries.
  *
+ * L2 tables are read ahead in batches of up to QCOW2_MAX_WORKERS concurrent
+ * requests; checking itself stays sequential so that the output does not
+ * depend on I/O completion order.
+ *
  * Returns the number of errors found by the checks or -errno if an internal
  * error occurred.
  */
@@ -1884,9 +1952,12 @@ check_refcounts_l1(BlockDriverState *bs, BdrvCheckResult *res,
 {
     BDRVQcow2State *s = bs->opaque;
     size_t l1_size_bytes = l1_size * L1E_SIZE;
+    size_t l2_size_bytes = s->l2_size * l2_entry_size(s);
     g_autofree uint64_t *l1_table = NULL;
+    g_autofree uint64_t *l2_tables = NULL;
+    int l2_ret[QCOW2_MAX_WORKERS];
     uint64_t l2_offset;
-    int i, ret;
+    int i, n, batch_start, batch_end, ret;
 
     if (!l1_size) {
         return 0;
@@ -1917,41 +1988,85 @@ check_refcounts_l1(BlockDriverState *bs, BdrvCheckResult *res,
         be64_to_cpus(&l1_table[i]);
     }
 
-    /* Do the actual checks */
-    for (i = 0; i < l1_size; i++) {
-        if (!l1_table[i]) {
-            continue;
-        }
+    l2_tables = g_try_malloc(QCOW2_MAX_WORKERS * l2_size_bytes);
+    if (l2_tables == NULL) {
+        res->check_errors++;
+        return -ENOMEM;
+    }
 
-        if (l1_table[i] & L1E_RESERVED_MASK) {
-            fprintf(stderr, "ERROR found L1 entry with reserved bits set: "
-                    "%" PRIx64 "\n", l1_table[i]);
-            res->corruptions++;
-        }
+    for (batch_start = 0; batch_start < l1_size; batch_start = batch_end) {
+        AioTaskPool *aio = aio_task_pool_new(QCOW2_MAX_WORKERS);
 
-        l2_offset = l1_table[i] & L1E_OFFSET_MASK;
+        /* Read the next batch of L2 tables */
+        for (i = batch_start, n = 0; i < l1_size && n < QCOW2_MAX_WORKERS;
+             i++)
+        {
+            Qcow2CheckL2ReadTask *task;
 
-        /* Mark L2 table as used */
-        ret = qcow2_inc_refcounts_imrt(bs, res,
-                                       refcount_table, refcount_table_size,
-                                       l2_offset, s->cluster_size);
-        if (ret < 0) {
-            return ret;
-        }
+            if (!l1_table[i]) {
+                continue;
+            }
 
-        /* L2 tables are cluster aligned */
-        if (offset_into_cluster(s, l2_offset)) {
-            fprintf(stderr, "ERROR l2_offset=%" PRIx64 ": Table is not "
-                "cluster aligned; L1 entry corrupted\n", l2_offset);
-            res->corruptions++;
+            task = g_new(Qcow2CheckL2ReadTask, 1);
+            *task = (Qcow2CheckL2ReadTask) {
+                .task.func = check_refcounts_l2_read_task_entry,
+                .bs = bs,
+                .l2_offset = l1_table[i] & L1E_OFFSET_MASK,
+                .l2_table = l2_tables + n * (l2_size_bytes / sizeof(uint64_t)),
+                .ret = &l2_ret[n],
+            };
+            aio_task_pool_start_task(aio, &task->task);
+            n++;
         }
+        batch_end = i;
 
-        /* Process and check L2 entries */
-        ret = check_refcounts_l2(bs, res, refcount_table,
-                                 refcount_table_size, l2_offset, flags,
-                                 fix, active);
-        if (ret < 0) {
-            return ret;
+        aio_task_pool_wait_all(aio);
+        g_free(aio);
+
+        /* Do the actual checks */
+        for (i = batch_start, n = 0; i < batch_end; i++) {
+            if (!l1_table[i]) {
+                continue;
+            }
+
+            if (l1_table[i] & L1E_RESERVED_MASK) {
+                fprintf(stderr, "ERROR found L1 entry with reserved bits "
+                        "set: %" PRIx64 "\n", l1_table[i]);
+                res->corruptions++;
+            }
+
+            l2_offset = l1_table[i] & L1E_OFFSET_MASK;
+
+            /* Mark L2 table as used */
+            ret = qcow2_inc_refcounts_imrt(bs, res, refcount_table,
+                                           refcount_table_size,
+                                           l2_offset, s->cluster_size);
+            if (ret < 0) {
+                return ret;
+            }
+
+            /* L2 tables are cluster aligned */
+            if (offset_into_cluster(s, l2_offset)) {
+                fprintf(stderr, "ERROR l2_offset=%" PRIx64 ": Table is not "
+                    "cluster aligned; L1 entry corrupted\n", l2_offset);
+                res->corruptions++;
+            }
+
+            /* Process and check L2 entries */
+            if (l2_ret[n] < 0) {
+                fprintf(stderr, "ERROR: I/O error in check_refcounts_l2\n");
+                res->check_errors++;
+                return l2_ret[n];
+            }
+            ret = check_refcounts_l2(bs, res, refcount_table,
+                                     refcount_table_size, l2_offset,
+                                     l2_tables + n * (l2_size_bytes /
+                                                      sizeof(uint64_t)),
+                                     flags, fix, active);
+            if (ret < 0) {
+                return ret;
+            }
+            n++;
         }
     }
 
@@ -2873,10 +2873,12 @@ static void blockdev_mirror_common(const char *job_id, BlockDriverState *bs,
                                    bool has_copy_mode, MirrorCopyMode copy_mode,
                                    bool has_auto_finalize, bool auto_finalize,
                                    bool has_auto_dismiss, bool auto_dismiss,
+                                   MirrorPerf *perf,
                                    Error **errp)
 {
     BlockDriverState *unfiltered_bs;
     int job_flags = JOB_DEFAULT;
+    bool use_copy_range = false;
 
     GLOBAL_STATE_CODE();
     GRAPH_RDLOCK_GUARD_MAINLOOP();
@@ -2908,6 +2910,9 @@ static void blockdev_mirror_common(const char *job_id, BlockDriverState *bs,
     if (has_auto_dismiss && !auto_dismiss) {
         job_flags |= JOB_MANUAL_DISMISS;
     }
+    if (perf && perf->has_use_copy_range) {
+        use_copy_range = perf->use_copy_range;
+    }
 
     if (granularity != 0 && (granularity < 512 || granularity > 1048576 * 64)) {
         error_setg(errp, QERR_INVALID_PARAMETER_VALUE, "granularity",
@@ -2970,7 +2975,7 @@ static void blockdev_mirror_common(const char *job_id, BlockDriverState *bs,
     mirror_start(job_id, bs, target, replaces, job_flags,
                  speed, granularity, buf_size, sync, backing_mode,
                  target_is_zero, on_source_error, on_target_error, unmap,
-                 filter_node_name, copy_mode, errp);
+                 filter_node_name, copy_mode, use_copy_range, errp);
 }
 
 void qmp_drive_mirror(DriveMirror *arg, Error **errp)
@@ -3122,7 +3127,7 @@ void qmp_drive_mirror(DriveMirror *arg, Error **errp)
                            arg->has_copy_mode, arg->copy_mode,
                            arg->has_auto_finalize, arg->auto_finalize,
                            arg->has_auto_dismiss, arg->auto_dismiss,
-                           errp);
+                           NULL, errp);
     bdrv_unref(target_bs);
 }
 
@@ -3142,6 +3147,7 @@ void qmp_blockdev_mirror(const char *job_id,
                          bool has_auto_finalize, bool auto_finalize,
                          bool has_auto_dismiss, bool auto_dismiss,
                          bool has_target_is_zero, bool target_is_zero,
+                         MirrorPerf *x_perf,
                          Error **errp)
 {
     BlockDriverState *bs;
@@ -3179,7 +3185,7 @@ void qmp_blockdev_mirror(const char *job_id,
                            has_copy_mode, copy_mode,
                            has_auto_finalize, auto_finalize,
                            has_auto_dismiss, auto_dismiss,
-                           errp);
+                           x_perf, errp);
 }
 
 /*
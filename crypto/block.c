@@ -389,6 +389,16 @@ static int do_qcrypto_block_cipher_encdec(QCryptoCipher *cipher,
     assert(QEMU_IS_ALIGNED(offset, sectorsize));
     assert(QEMU_IS_ALIGNED(len, sectorsize));
 
+    /*
+     * Only the ESSIV generator has state (its own cipher) that must not be
+     * used concurrently.  The plain generators are pure functions of the
+     * sector number, so skip taking the lock for every sector.
+     */
+    if (niv && qcrypto_ivgen_get_algorithm(ivgen) !=
+        QCRYPTO_IV_GEN_ALGO_ESSIV) {
+        ivgen_mutex = NULL;
+    }
+
     while (len > 0) {
         size_t nbytes;
         if (niv) {
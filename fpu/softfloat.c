@@ -397,6 +397,93 @@ float64_gen2(float64 xa, float64 xb, float_status *s,
     return soft(ua.s, ub.s, s);
 }
 
+/*
+ * Batched flavors of float32_gen2() and float64_gen2(), applying the
+ * operation lane-wise to @n elements.  can_use_fpu() is checked once for
+ * the batch.  Each chunk of lanes is then computed on the host FPU into a
+ * temporary, and stored only if every lane passed the same checks as the
+ * scalar fast path, i.e. no flag beyond the already raised inexact can
+ * result.  Otherwise the chunk is redone lane by lane with @scalar, which
+ * raises the exact flags.  @d may alias @a or @b.
+ */
+#define GEN2_N_CHUNK 16
+
+static inline void
+float32_gen2_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+               float_status *s, hard_f32_op2_fn hard, soft_f32_op2_fn scalar,
+               f32_check_fn pre, f32_check_fn post)
+{
+    size_t i, j, len;
+
+    if (unlikely(!can_use_fpu(s))) {
+        for (i = 0; i < n; i++) {
+            d[i] = scalar(a[i], b[i], s);
+        }
+        return;
+    }
+
+    for (i = 0; i < n; i += len) {
+        union_float32 ur[GEN2_N_CHUNK];
+        bool ok = true;
+
+        len = MIN(n - i, GEN2_N_CHUNK);
+        for (j = 0; j < len; j++) {
+            union_float32 ua = { .s = a[i + j] }, ub = { .s = b[i + j] };
+
+            ur[j].h = hard(ua.h, ub.h);
+            ok &= pre(ua, ub) && !f32_is_inf(ur[j]) &&
+                  (fabsf(ur[j].h) > FLT_MIN || !post(ua, ub));
+        }
+        if (likely(ok)) {
+            for (j = 0; j < len; j++) {
+                d[i + j] = ur[j].s;
+            }
+        } else {
+            for (j = 0; j < len; j++) {
+                d[i + j] = scalar(a[i + j], b[i + j], s);
+            }
+        }
+    }
+}
+
+static inline void
+float64_gen2_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+               float_status *s, hard_f64_op2_fn hard, soft_f64_op2_fn scalar,
+               f64_check_fn pre, f64_check_fn post)
+{
+    size_t i, j, len;
+
+    if (unlikely(!can_use_fpu(s))) {
+        for (i = 0; i < n; i++) {
+            d[i] = scalar(a[i], b[i], s);
+        }
+        return;
+    }
+
+    for (i = 0; i < n; i += len) {
+        union_float64 ur[GEN2_N_CHUNK];
+        bool ok = true;
+
+        len = MIN(n - i, GEN2_N_CHUNK);
+        for (j = 0; j < len; j++) {
+            union_float64 ua = { .s = a[i + j] }, ub = { .s = b[i + j] };
+
+            ur[j].h = hard(ua.h, ub.h);
+            ok &= pre(ua, ub) && !f64_is_inf(ur[j]) &&
+                  (fabs(ur[j].h) > DBL_MIN || !post(ua, ub));
+        }
+        if (likely(ok)) {
+            for (j = 0; j < len; j++) {
+                d[i + j] = ur[j].s;
+            }
+        } else {
+            for (j = 0; j < len; j++) {
+                d[i + j] = scalar(a[i + j], b[i + j], s);
+            }
+        }
+    }
+}
+
 /* Simple helpers for checking if, or what kind of, NaN we have */
 static inline __attribute__((unused)) bool is_nan(FloatClass c)
 {
@@ -1728,6 +1815,34 @@ float64_sub(float64 a, float64 b, float_status *s)
     return float64_addsub(a, b, s, hard_f64_sub, soft_f64_sub);
 }
 
+void float32_add_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_add, float32_add,
+                   f32_is_zon2, f32_addsubmul_post);
+}
+
+void float32_sub_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_sub, float32_sub,
+                   f32_is_zon2, f32_addsubmul_post);
+}
+
+void float64_add_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_add, float64_add,
+                   f64_is_zon2, f64_addsubmul_post);
+}
+
+void float64_sub_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_sub, float64_sub,
+                   f64_is_zon2, f64_addsubmul_post);
+}
+
 static float64 float64r32_addsub(float64 a, float64 b, float_status *status,
                                  bool subtract)
 {
@@ -1869,6 +1984,20 @@ float64_mul(float64 a, float64 b, float_status *s)
                         f64_is_zon2, f64_addsubmul_post);
 }
 
+void float32_mul_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_mul, float32_mul,
+                   f32_is_zon2, f32_addsubmul_post);
+}
+
+void float64_mul_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_mul, float64_mul,
+                   f64_is_zon2, f64_addsubmul_post);
+}
+
 float64 float64r32_mul(float64 a, float64 b, float_status *status)
 {
     FloatParts64 pa = float64_unpack_canonical(a, status);
@@ -271,6 +271,21 @@ SRST
     being coalesced.
 ERST
 
+    {
+        .name       = "coroutine-pool",
+        .args_type  = "",
+        .params     = "",
+        .help       = "show coroutine pool statistics",
+        .cmd_info_hrt = qmp_x_query_coroutine_pool,
+    },
+
+SRST
+  ``info coroutine-pool``
+    Show how many coroutines were reused from the coroutine pool, how many
+    had to be allocated because the pool was empty, and how many were freed
+    because the pool was full.
+ERST
+
     {
         .name       = "accel",
         .args_type  = "",
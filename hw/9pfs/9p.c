@@ -2107,14 +2107,6 @@ out_pdu_complete:
     pdu_complete(pdu, err);
 }
 
-static int32_t coroutine_fn get_iounit(V9fsPDU *pdu, V9fsPath *path)
-{
-    struct statfs stbuf;
-    int err = v9fs_co_statfs(pdu, path, &stbuf);
-
-    return blksize_to_iounit(pdu, (err >= 0) ? stbuf.f_bsize : 0);
-}
-
 static void coroutine_fn v9fs_open(void *opaque)
 {
     int flags;
@@ -2203,7 +2195,7 @@ static void coroutine_fn v9fs_open(void *opaque)
              */
             fidp->flags |= FID_NON_RECLAIMABLE;
         }
-        iounit = get_iounit(pdu, &fidp->path);
+        iounit = stat_to_iounit(pdu, &stbuf);
         err = pdu_marshal(pdu, offset, "Qd", &qid, iounit);
         if (err < 0) {
             goto out;
@@ -2269,7 +2261,7 @@ static void coroutine_fn v9fs_lcreate(void *opaque)
          */
         fidp->flags |= FID_NON_RECLAIMABLE;
     }
-    iounit =  get_iounit(pdu, &fidp->path);
+    iounit = stat_to_iounit(pdu, &stbuf);
     err = stat_to_qid(pdu, &stbuf, &qid);
     if (err < 0) {
         goto out;
@@ -3097,7 +3089,7 @@ static void coroutine_fn v9fs_create(void *opaque)
             fidp->flags |= FID_NON_RECLAIMABLE;
         }
     }
-    iounit = get_iounit(pdu, &fidp->path);
+    iounit = stat_to_iounit(pdu, &stbuf);
     err = stat_to_qid(pdu, &stbuf, &qid);
     if (err < 0) {
         goto out;
@@ -198,6 +198,7 @@
 #include "qemu/osdep.h"
 #include "qemu/bitops.h"
 #include "qemu/cutils.h"
+#include "qemu/defer-call.h"
 #include "qemu/error-report.h"
 #include "qemu/log.h"
 #include "qemu/units.h"
@@ -872,6 +873,21 @@ static uint16_t nvme_map_addr(NvmeCtrl *n, NvmeSg *sg, hwaddr addr, size_t len)
         return NVME_INVALID_USE_OF_CMB | NVME_DNR;
     }
 
+    /*
+     * PRP lists commonly describe physically contiguous pages; extend the
+     * previous entry so that the transfer is mapped in as few chunks as
+     * possible.
+     */
+    if (sg->qsg.nsg) {
+        ScatterGatherEntry *last = &sg->qsg.sg[sg->qsg.nsg - 1];
+
+        if (last->base + last->len == addr) {
+            last->len += len;
+            sg->qsg.size += len;
+            return NVME_SUCCESS;
+        }
+    }
+
     if (sg->qsg.nsg + 1 > IOV_MAX) {
         goto max_mappings_exceeded;
     }
@@ -7928,6 +7944,9 @@ static void nvme_process_sq(void *opaque)
         nvme_update_sq_tail(sq);
     }
 
+    /* Let the block layer submit the I/O of all fetched commands at once */
+    defer_call_begin();
+
     while (!(nvme_sq_empty(sq) || QTAILQ_EMPTY(&sq->req_list))) {
         NvmeAtomic *atomic;
         bool cmd_is_atomic;
@@ -7950,7 +7969,7 @@ static void nvme_process_sq(void *opaque)
             switch (ret) {
             case NVME_ATOMIC_NO_START:
                 qemu_bh_schedule(sq->bh);
-                return;
+                goto out;
             case NVME_ATOMIC_START_ATOMIC:
                 cmd_is_atomic = true;
                 break;
@@ -7985,6 +8004,9 @@ static void nvme_process_sq(void *opaque)
             nvme_update_sq_tail(sq);
         }
     }
+
+out:
+    defer_call_end();
 }
 
 static void nvme_update_msixcap_ts(PCIDevice *pci_dev, uint32_t table_size)
@@ -633,6 +633,18 @@ bool float32_is_signaling_nan(float32, float_status *status);
 float32 float32_silence_nan(float32, float_status *status);
 float32 float32_scalbn(float32, int, float_status *status);
 
+/*
+ * Lane-wise d[i] = a[i] op b[i] for 0 <= i < n, with the same results and
+ * exception flags as calling the scalar function for each lane in turn.
+ * @d may alias @a or @b.
+ */
+void float32_add_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *status);
+void float32_sub_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *status);
+void float32_mul_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *status);
+
 static inline float32 float32_abs(float32 a)
 {
     /* Note that abs does *not* handle NaN specially, nor does
@@ -822,6 +834,14 @@ bool float64_is_signaling_nan(float64, float_status *status);
 float64 float64_silence_nan(float64, float_status *status);
 float64 float64_scalbn(float64, int, float_status *status);
 
+/* Lane-wise operations, see float32_add_n() */
+void float64_add_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *status);
+void float64_sub_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *status);
+void float64_mul_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *status);
+
 static inline float64 float64_abs(float64 a)
 {
     /* Note that abs does *not* handle NaN specially, nor does
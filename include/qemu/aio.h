@@ -312,6 +312,14 @@ struct AioContext {
     int64_t poll_shrink;    /* polling time shrink factor */
     int64_t poll_weight;    /* weight of current interval in calculation */
 
+    /*
+     * Polling statistics.  Only written by the AioContext's home thread,
+     * read with qatomic_read() by query-iothreads.
+     */
+    uint64_t poll_success;  /* polling rounds that made progress */
+    uint64_t poll_fail;     /* polling rounds that used up poll_ns */
+    uint64_t poll_wasted_ns; /* time spent in those rounds */
+
     /* AIO engine parameters */
     int64_t aio_max_batch;  /* maximum number of requests in a batch */
 
@@ -293,6 +293,18 @@ void qemu_coroutine_inc_pool_size(unsigned int additional_pool_size);
  */
 void qemu_coroutine_dec_pool_size(unsigned int additional_pool_size);
 
+/**
+ * Get coroutine pool statistics
+ * @hits: number of coroutines reused from the pool
+ * @misses: number of coroutines allocated because the pool was empty
+ * @discarded: number of coroutines freed because the pool was full
+ *
+ * Hits are accounted per batch, so up to one batch of recent hits per
+ * thread may not be reflected yet.
+ */
+void qemu_coroutine_get_pool_stats(uint64_t *hits, uint64_t *misses,
+                                   uint64_t *discarded);
+
 /**
  * Sends a (part of) iovec down a socket, yielding when the socket is full, or
  * Receives data into a (part of) iovec from a socket,
@@ -378,6 +378,11 @@ static int query_one_iothread(Object *object, void *opaque)
     info->poll_shrink = iothread->poll_shrink;
     info->poll_weight = iothread->poll_weight;
     info->aio_max_batch = iothread->parent_obj.aio_max_batch;
+    if (iothread->ctx) {
+        info->poll_success = qatomic_read(&iothread->ctx->poll_success);
+        info->poll_fail = qatomic_read(&iothread->ctx->poll_fail);
+        info->poll_wasted_ns = qatomic_read(&iothread->ctx->poll_wasted_ns);
+    }
 
     QAPI_LIST_APPEND(*tail, info);
     return 0;
@@ -22,8 +22,18 @@
 #include "migration/channel-block.h"
 #include "qapi/error.h"
 #include "block/block.h"
+#include "qemu/iov.h"
+#include "qemu/units.h"
 #include "trace.h"
 
+/*
+ * QEMUFile hands us at most a few hundred kilobytes per writev, which for
+ * qcow2 means a handful of clusters per request.  Coalesce sequential writes
+ * so that the format driver sees requests large enough to spread over its
+ * parallel write tasks.
+ */
+#define QIO_CHANNEL_BLOCK_WBUF_SIZE (4 * MiB)
+
 QIOChannelBlock *
 qio_channel_block_new(BlockDriverState *bs)
 {
@@ -45,6 +55,30 @@ qio_channel_block_finalize(Object *obj)
     QIOChannelBlock *ioc = QIO_CHANNEL_BLOCK(obj);
 
     g_clear_pointer(&ioc->bs, bdrv_unref);
+    g_free(ioc->wbuf);
+}
+
+
+static int
+qio_channel_block_flush_wbuf(QIOChannelBlock *bioc,
+                             Error **errp)
+{
+    QEMUIOVector qiov;
+    int ret;
+
+    if (!bioc->wbuf_len) {
+        return 0;
+    }
+
+    qemu_iovec_init_buf(&qiov, bioc->wbuf, bioc->wbuf_len);
+    ret = bdrv_writev_vmstate(bioc->bs, &qiov, bioc->offset - bioc->wbuf_len);
+    bioc->wbuf_len = 0;
+    if (ret < 0) {
+        error_setg_errno(errp, -ret, "bdrv_writev_vmstate failed");
+        return -1;
+    }
+
+    return 0;
 }
 
 
@@ -61,6 +95,10 @@ qio_channel_block_readv(QIOChannel *ioc,
     QEMUIOVector qiov;
     int ret;
 
+    if (qio_channel_block_flush_wbuf(bioc, errp) < 0) {
+        return -1;
+    }
+
     qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
     ret = bdrv_readv_vmstate(bioc->bs, &qiov, bioc->offset);
     if (ret < 0) {
@@ -84,8 +122,25 @@ qio_channel_block_writev(QIOChannel *ioc,
 {
     QIOChannelBlock *bioc = QIO_CHANNEL_BLOCK(ioc);
     QEMUIOVector qiov;
+    size_t size = iov_size(iov, niov);
     int ret;
 
+    if (bioc->wbuf_len + size > QIO_CHANNEL_BLOCK_WBUF_SIZE) {
+        if (qio_channel_block_flush_wbuf(bioc, errp) < 0) {
+            return -1;
+        }
+    }
+
+    if (size < QIO_CHANNEL_BLOCK_WBUF_SIZE) {
+        if (!bioc->wbuf) {
+            bioc->wbuf = g_malloc(QIO_CHANNEL_BLOCK_WBUF_SIZE);
+        }
+        iov_to_buf(iov, niov, 0, bioc->wbuf + bioc->wbuf_len, size);
+        bioc->wbuf_len += size;
+        bioc->offset += size;
+        return size;
+    }
+
     qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
     ret = bdrv_writev_vmstate(bioc->bs, &qiov, bioc->offset);
     if (ret < 0) {
@@ -108,6 +163,10 @@ qio_channel_block_preadv(QIOChannel *ioc,
     QEMUIOVector qiov;
     int ret;
 
+    if (qio_channel_block_flush_wbuf(bioc, errp) < 0) {
+        return -1;
+    }
+
     qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
     ret = bdrv_readv_vmstate(bioc->bs, &qiov, offset);
     if (ret < 0) {
@@ -129,6 +188,10 @@ qio_channel_block_pwritev(QIOChannel *ioc,
     QEMUIOVector qiov;
     int ret;
 
+    if (qio_channel_block_flush_wbuf(bioc, errp) < 0) {
+        return -1;
+    }
+
     qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
     ret = bdrv_writev_vmstate(bioc->bs, &qiov, offset);
     if (ret < 0) {
@@ -160,6 +223,10 @@ qio_channel_block_seek(QIOChannel *ioc,
 {
     QIOChannelBlock *bioc = QIO_CHANNEL_BLOCK(ioc);
 
+    if (qio_channel_block_flush_wbuf(bioc, errp) < 0) {
+        return (off_t)-1;
+    }
+
     switch (whence) {
     case SEEK_SET:
         bioc->offset = offset;
@@ -183,8 +250,13 @@ qio_channel_block_close(QIOChannel *ioc,
                         Error **errp)
 {
     QIOChannelBlock *bioc = QIO_CHANNEL_BLOCK(ioc);
-    int rv = bdrv_flush(bioc->bs);
+    int rv;
+
+    if (qio_channel_block_flush_wbuf(bioc, errp) < 0) {
+        return -1;
+    }
 
+    rv = bdrv_flush(bioc->bs);
     if (rv < 0) {
         error_setg_errno(errp, -rv,
                          "Unable to flush VMState");
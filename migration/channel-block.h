@@ -40,6 +40,9 @@ struct QIOChannelBlock {
     QIOChannel parent;
     BlockDriverState *bs;
     off_t offset;
+    /* Sequential writes not yet passed down, ending at @offset */
+    uint8_t *wbuf;
+    size_t wbuf_len;
 };
 
 
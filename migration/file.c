@@ -254,6 +254,22 @@ int file_write_ramblock_iov(QIOChannel *ioc, const struct iovec *iov,
     return ret;
 }
 
+/*
+ * Hint the kernel that @len bytes at @offset of the migration file will be
+ * read soon, so that readahead for them overlaps with loading the pages
+ * that precede them.  Channels that are not backed by a file are ignored.
+ */
+void file_prefetch(QIOChannel *ioc, off_t offset, off_t len)
+{
+#ifdef CONFIG_POSIX_FADVISE
+    if (object_dynamic_cast(OBJECT(ioc), TYPE_QIO_CHANNEL_FILE)) {
+        /* Only a hint, nothing to do on failure */
+        posix_fadvise(QIO_CHANNEL_FILE(ioc)->fd, offset, len,
+                      POSIX_FADV_WILLNEED);
+    }
+#endif
+}
+
 int multifd_file_recv_data(MultiFDRecvParams *p, Error **errp)
 {
     ERRP_GUARD();
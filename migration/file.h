@@ -23,5 +23,6 @@ void file_cleanup_outgoing_migration(void);
 bool file_send_channel_create(gpointer opaque, Error **errp);
 int file_write_ramblock_iov(QIOChannel *ioc, const struct iovec *iov,
                             int niov, MultiFDPages_t *pages, Error **errp);
+void file_prefetch(QIOChannel *ioc, off_t offset, off_t len);
 int multifd_file_recv_data(MultiFDRecvParams *p, Error **errp);
 #endif
@@ -58,6 +58,7 @@
 #include "savevm.h"
 #include "qemu/iov.h"
 #include "multifd.h"
+#include "file.h"
 #include "system/runstate.h"
 #include "rdma.h"
 #include "options.h"
@@ -91,6 +92,12 @@
  */
 #define MAPPED_RAM_LOAD_BUF_SIZE 0x100000
 
+/*
+ * How far ahead of the current read position the pages region is
+ * prefetched into the page cache during a mapped-ram load.
+ */
+#define MAPPED_RAM_PREFETCH_SIZE (16 * MAPPED_RAM_LOAD_BUF_SIZE)
+
 XBZRLECacheStats xbzrle_counters;
 
 /*
@@ -4079,6 +4086,17 @@ static bool handle_zero_mapped_ram(RAMBlock *block, unsigned long from_bit_idx,
     return true;
 }
 
+static void mapped_ram_prefetch(QEMUFile *f, RAMBlock *block,
+                                ram_addr_t offset, size_t size)
+{
+    /* O_DIRECT reads bypass the page cache, prefetching would only hurt */
+    if (migrate_direct_io()) {
+        return;
+    }
+
+    file_prefetch(qemu_file_get_ioc(f), block->pages_offset + offset, size);
+}
+
 static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
                                      long num_pages, unsigned long *bitmap,
                                      Error **errp)
@@ -4104,6 +4122,9 @@ static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
         unread = TARGET_PAGE_SIZE * (clear_bit_idx - set_bit_idx);
         offset = set_bit_idx << TARGET_PAGE_BITS;
 
+        mapped_ram_prefetch(f, block, offset,
+                            MIN(unread, MAPPED_RAM_PREFETCH_SIZE));
+
         while (unread > 0) {
             host = host_from_ram_block_offset(block, offset);
             if (!host) {
@@ -4114,6 +4135,14 @@ static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
 
             size = MIN(unread, MAPPED_RAM_LOAD_BUF_SIZE);
 
+            /* Keep the prefetch window a fixed distance ahead */
+            if (unread > MAPPED_RAM_PREFETCH_SIZE) {
+                mapped_ram_prefetch(f, block,
+                                    offset + MAPPED_RAM_PREFETCH_SIZE,
+                                    MIN(size,
+                                        unread - MAPPED_RAM_PREFETCH_SIZE));
+            }
+
             if (migrate_multifd()) {
                 read = ram_load_multifd_pages(host, size,
                                               block->pages_offset + offset);
@@ -251,6 +251,11 @@ void hmp_info_iothreads(Monitor *mon, const QDict *qdict)
         monitor_printf(mon, "  poll-weight=%" PRId64 "\n", value->poll_weight);
         monitor_printf(mon, "  aio-max-batch=%" PRId64 "\n",
                        value->aio_max_batch);
+        monitor_printf(mon, "  poll-success=%" PRIu64 "\n",
+                       value->poll_success);
+        monitor_printf(mon, "  poll-fail=%" PRIu64 "\n", value->poll_fail);
+        monitor_printf(mon, "  poll-wasted-ns=%" PRIu64 "\n",
+                       value->poll_wasted_ns);
     }
 
     qapi_free_IOThreadInfoList(info_list);
@@ -14,6 +14,7 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/coroutine.h"
 #include "qemu/sockets.h"
 #include "monitor-internal.h"
 #include "monitor/qdev.h"
@@ -188,6 +189,23 @@ out:
     return output;
 }
 
+HumanReadableText *qmp_x_query_coroutine_pool(Error **errp)
+{
+    g_autoptr(GString) buf = g_string_new("");
+    uint64_t hits, misses, discarded;
+
+    qemu_coroutine_get_pool_stats(&hits, &misses, &discarded);
+    g_string_append_printf(buf, "hits:      %" PRIu64 "\n", hits);
+    g_string_append_printf(buf, "misses:    %" PRIu64 "\n", misses);
+    g_string_append_printf(buf, "discarded: %" PRIu64 "\n", discarded);
+    if (hits + misses) {
+        g_string_append_printf(buf, "hit rate:  %.2f%%\n",
+                               (double)hits * 100 / (hits + misses));
+    }
+
+    return human_readable_text_from_str(buf);
+}
+
 static void __attribute__((__constructor__)) monitor_init_qmp_commands(void)
 {
     /*
@@ -1458,20 +1458,20 @@ static float32 float32_rsqrts_nf(float32 op1, float32 op2, float_status *stat)
 
 DO_3OP(gvec_fadd_b16, bfloat16_add, float16)
 DO_3OP(gvec_fadd_h, float16_add, float16)
-DO_3OP(gvec_fadd_s, float32_add, float32)
-DO_3OP(gvec_fadd_d, float64_add, float64)
+DO_3OP_N(gvec_fadd_s, float32_add_n, float32)
+DO_3OP_N(gvec_fadd_d, float64_add_n, float64)
 DO_3OP(gvec_bfadd, bfloat16_add, bfloat16)
 
 DO_3OP(gvec_fsub_b16, bfloat16_sub, float16)
 DO_3OP(gvec_fsub_h, float16_sub, float16)
-DO_3OP(gvec_fsub_s, float32_sub, float32)
-DO_3OP(gvec_fsub_d, float64_sub, float64)
+DO_3OP_N(gvec_fsub_s, float32_sub_n, float32)
+DO_3OP_N(gvec_fsub_d, float64_sub_n, float64)
 DO_3OP(gvec_bfsub, bfloat16_sub, bfloat16)
 
 DO_3OP(gvec_fmul_b16, bfloat16_mul, float16)
 DO_3OP(gvec_fmul_h, float16_mul, float16)
-DO_3OP(gvec_fmul_s, float32_mul, float32)
-DO_3OP(gvec_fmul_d, float64_mul, float64)
+DO_3OP_N(gvec_fmul_s, float32_mul_n, float32)
+DO_3OP_N(gvec_fmul_d, float64_mul_n, float64)
 
 DO_3OP(gvec_ftsmul_h, float16_ftsmul, float16)
 DO_3OP(gvec_ftsmul_s, float32_ftsmul, float32)
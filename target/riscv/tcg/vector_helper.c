@@ -302,23 +302,97 @@ static void vext_set_tail_elems_1s(uint32_t vl, void *vd,
     }
 }
 
+/*
+ * Return a host pointer for the guest range [addr, addr + len) if it lies
+ * within a single page that can be accessed directly, or NULL if any part
+ * of it needs to go through the slow path (unmapped, MMIO, watchpoint,
+ * dirty tracking, ...).  Never raises an exception: the caller falls back
+ * to per-element accesses, which fault exactly as before.
+ */
+static void *vext_probe_host_range(CPURISCVState *env, target_ulong addr,
+                                   target_ulong len, MMUAccessType access_type,
+                                   uintptr_t ra)
+{
+    int mmu_index = riscv_env_mmu_index(env, false);
+    void *host;
+    int flags;
+
+    if (len > -(addr | TARGET_PAGE_MASK)) {
+        return NULL;
+    }
+    probe_pages(env, addr, len, ra, access_type, mmu_index, &host, &flags,
+                true);
+    return flags == 0 ? host : NULL;
+}
+
 /*
  * stride: access vector element from strided memory
  */
 static void
 vext_ldst_stride(void *vd, void *v0, target_ulong base, target_ulong stride,
                  CPURISCVState *env, uint32_t desc, uint32_t vm,
-                 vext_ldst_elem_fn_tlb *ldst_elem, uint32_t log2_esz,
-                 uintptr_t ra)
+                 vext_ldst_elem_fn_tlb *ldst_elem,
+                 vext_ldst_elem_fn_host *ldst_host, uint32_t log2_esz,
+                 uintptr_t ra, bool is_load)
 {
     uint32_t i, k;
     uint32_t nf = vext_nf(desc);
     uint32_t max_elems = vext_max_elems(desc, log2_esz);
     uint32_t esz = 1 << log2_esz;
     uint32_t vma = vext_vma(desc);
+    uint32_t first, last;
+    void *host = NULL;
 
     VSTART_CHECK_EARLY_EXIT(env, env->vl);
 
+    /*
+     * Find the first and last active elements; masked-off elements are not
+     * accessed at all, so they must not be probed either.
+     */
+    first = env->vstart;
+    last = env->vl - 1;
+    if (!vm) {
+        while (first <= last && !vext_elem_mask(v0, first)) {
+            first++;
+        }
+        while (last > first && !vext_elem_mask(v0, last)) {
+            last--;
+        }
+    }
+
+    /*
+     * If every active element falls into the same page, probe that page
+     * once and access the elements through the host pointer instead of
+     * doing a TLB lookup per element.  Only non-negative strides no larger
+     * than a page are considered, so the span below cannot overflow.
+     */
+    if (first <= last && stride <= TARGET_PAGE_SIZE) {
+        target_ulong start = base + stride * first;
+        target_ulong span = stride * (last - first) + (nf << log2_esz);
+
+        host = vext_probe_host_range(env, start, span,
+                                     is_load ? MMU_DATA_LOAD : MMU_DATA_STORE,
+                                     ra);
+    }
+
+    if (host) {
+        for (i = env->vstart; i < env->vl; i++) {
+            for (k = 0; k < nf; k++) {
+                if (!vm && !vext_elem_mask(v0, i)) {
+                    /* set masked-off elements to 1s */
+                    vext_set_elems_1s(vd, vma, (i + k * max_elems) * esz,
+                                      (i + k * max_elems + 1) * esz);
+                    continue;
+                }
+                ldst_host(vd, i + k * max_elems,
+                          host + stride * (i - first) + (k << log2_esz));
+            }
+        }
+        env->vstart = 0;
+        vext_set_tail_elems_1s(env->vl, vd, desc, nf, esz, max_elems);
+        return;
+    }
+
     for (i = env->vstart; i < env->vl; env->vstart = ++i) {
         k = 0;
         while (k < nf) {
@@ -339,35 +413,36 @@ vext_ldst_stride(void *vd, void *v0, target_ulong base, target_ulong stride,
     vext_set_tail_elems_1s(env->vl, vd, desc, nf, esz, max_elems);
 }
 
-#define GEN_VEXT_LD_STRIDE(NAME, ETYPE, LOAD_FN)                        \
+#define GEN_VEXT_LD_STRIDE(NAME, ETYPE, LOAD_FN_TLB, LOAD_FN_HOST)      \
 void HELPER(NAME)(void *vd, void * v0, target_ulong base,               \
                   target_ulong stride, CPURISCVState *env,              \
                   uint32_t desc)                                        \
 {                                                                       \
     uint32_t vm = vext_vm(desc);                                        \
-    vext_ldst_stride(vd, v0, base, stride, env, desc, vm, LOAD_FN,      \
-                     ctzl(sizeof(ETYPE)), GETPC());                     \
+    vext_ldst_stride(vd, v0, base, stride, env, desc, vm, LOAD_FN_TLB,  \
+                     LOAD_FN_HOST, ctzl(sizeof(ETYPE)), GETPC(), true); \
 }
 
-GEN_VEXT_LD_STRIDE(vlse8_v,  int8_t,  lde_b_tlb)
-GEN_VEXT_LD_STRIDE(vlse16_v, int16_t, lde_h_tlb)
-GEN_VEXT_LD_STRIDE(vlse32_v, int32_t, lde_w_tlb)
-GEN_VEXT_LD_STRIDE(vlse64_v, int64_t, lde_d_tlb)
+GEN_VEXT_LD_STRIDE(vlse8_v,  int8_t,  lde_b_tlb, lde_b_host)
+GEN_VEXT_LD_STRIDE(vlse16_v, int16_t, lde_h_tlb, lde_h_host)
+GEN_VEXT_LD_STRIDE(vlse32_v, int32_t, lde_w_tlb, lde_w_host)
+GEN_VEXT_LD_STRIDE(vlse64_v, int64_t, lde_d_tlb, lde_d_host)
 
-#define GEN_VEXT_ST_STRIDE(NAME, ETYPE, STORE_FN)                       \
+#define GEN_VEXT_ST_STRIDE(NAME, ETYPE, STORE_FN_TLB, STORE_FN_HOST)    \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,                \
                   target_ulong stride, CPURISCVState *env,              \
                   uint32_t desc)                                        \
 {                                                                       \
     uint32_t vm = vext_vm(desc);                                        \
-    vext_ldst_stride(vd, v0, base, stride, env, desc, vm, STORE_FN,     \
-                     ctzl(sizeof(ETYPE)), GETPC());                     \
+    vext_ldst_stride(vd, v0, base, stride, env, desc, vm, STORE_FN_TLB, \
+                     STORE_FN_HOST, ctzl(sizeof(ETYPE)), GETPC(),       \
+                     false);                                            \
 }
 
-GEN_VEXT_ST_STRIDE(vsse8_v,  int8_t,  ste_b_tlb)
-GEN_VEXT_ST_STRIDE(vsse16_v, int16_t, ste_h_tlb)
-GEN_VEXT_ST_STRIDE(vsse32_v, int32_t, ste_w_tlb)
-GEN_VEXT_ST_STRIDE(vsse64_v, int64_t, ste_d_tlb)
+GEN_VEXT_ST_STRIDE(vsse8_v,  int8_t,  ste_b_tlb, ste_b_host)
+GEN_VEXT_ST_STRIDE(vsse16_v, int16_t, ste_h_tlb, ste_h_host)
+GEN_VEXT_ST_STRIDE(vsse32_v, int32_t, ste_w_tlb, ste_w_host)
+GEN_VEXT_ST_STRIDE(vsse64_v, int64_t, ste_d_tlb, ste_d_host)
 
 /*
  * unit-stride: access elements stored contiguously in memory
@@ -515,7 +590,8 @@ void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,     \
 {                                                                   \
     uint32_t stride = vext_nf(desc) << ctzl(sizeof(ETYPE));         \
     vext_ldst_stride(vd, v0, base, stride, env, desc, false,        \
-                     LOAD_FN_TLB, ctzl(sizeof(ETYPE)), GETPC());    \
+                     LOAD_FN_TLB, LOAD_FN_HOST,                     \
+                     ctzl(sizeof(ETYPE)), GETPC(), true);           \
 }                                                                   \
                                                                     \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,            \
@@ -536,7 +612,8 @@ void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,          \
 {                                                                        \
     uint32_t stride = vext_nf(desc) << ctzl(sizeof(ETYPE));              \
     vext_ldst_stride(vd, v0, base, stride, env, desc, false,             \
-                     STORE_FN_TLB, ctzl(sizeof(ETYPE)), GETPC());        \
+                     STORE_FN_TLB, STORE_FN_HOST, ctzl(sizeof(ETYPE)),   \
+                     GETPC(), false);                                    \
 }                                                                        \
                                                                          \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,                 \
@@ -14,6 +14,7 @@
 #include "qemu/units.h"
 #include "crypto/init.h"
 #include "crypto/cipher.h"
+#include "crypto/ivgen.h"
 
 static void test_cipher_speed(size_t chunk_size,
                               QCryptoCipherMode mode,
@@ -164,6 +165,84 @@ static void test_cipher_speed_xts_aes_256(const void *opaque)
                       QCRYPTO_CIPHER_ALGO_AES_256);
 }
 
+/*
+ * Mimic disk encryption as done by qcrypto_block: process a buffer one
+ * sector at a time, generating and setting a plain64 IV for each sector.
+ */
+static void test_cipher_speed_sectors(size_t sector_size,
+                                      QCryptoCipherAlgo alg)
+{
+    QCryptoCipherMode mode = QCRYPTO_CIPHER_MODE_XTS;
+    QCryptoCipher *cipher;
+    QCryptoIVGen *ivgen;
+    Error *err = NULL;
+    uint8_t *key = NULL, *iv = NULL;
+    uint8_t *buf = NULL;
+    size_t nkey;
+    size_t niv;
+    const size_t buf_size = 1 * MiB;
+    const size_t total = 2 * GiB;
+    size_t remain, done;
+    uint64_t sector = 0;
+
+    if (!qcrypto_cipher_supports(alg, mode)) {
+        return;
+    }
+
+    nkey = qcrypto_cipher_get_key_len(alg) * 2;
+    niv = qcrypto_cipher_get_iv_len(alg, mode);
+
+    key = g_new0(uint8_t, nkey);
+    memset(key, g_test_rand_int(), nkey);
+
+    iv = g_new0(uint8_t, niv);
+
+    buf = g_new0(uint8_t, buf_size);
+    memset(buf, g_test_rand_int(), buf_size);
+
+    cipher = qcrypto_cipher_new(alg, mode, key, nkey, &err);
+    g_assert(cipher != NULL);
+
+    ivgen = qcrypto_ivgen_new(QCRYPTO_IV_GEN_ALGO_PLAIN64, 0, 0, NULL, 0,
+                              &err);
+    g_assert(ivgen != NULL);
+
+    g_test_timer_start();
+    remain = total;
+    while (remain) {
+        for (done = 0; done < buf_size; done += sector_size) {
+            g_assert(qcrypto_ivgen_calculate(ivgen, sector++, iv, niv,
+                                             &err) == 0);
+            g_assert(qcrypto_cipher_setiv(cipher, iv, niv, &err) == 0);
+            g_assert(qcrypto_cipher_encrypt(cipher, buf + done, buf + done,
+                                            sector_size, &err) == 0);
+        }
+        remain -= buf_size;
+    }
+    g_test_timer_elapsed();
+
+    g_test_message("enc(%s-%s-plain64) sector %zu bytes %.2f GB/sec ",
+                   QCryptoCipherAlgo_str(alg),
+                   QCryptoCipherMode_str(mode),
+                   sector_size, (double)total / GiB / g_test_timer_last());
+
+    qcrypto_ivgen_free(ivgen);
+    qcrypto_cipher_free(cipher);
+    g_free(buf);
+    g_free(iv);
+    g_free(key);
+}
+
+static void test_cipher_speed_sectors_xts_aes_128(const void *opaque)
+{
+    test_cipher_speed_sectors((size_t)opaque, QCRYPTO_CIPHER_ALGO_AES_128);
+}
+
+static void test_cipher_speed_sectors_xts_aes_256(const void *opaque)
+{
+    test_cipher_speed_sectors((size_t)opaque, QCRYPTO_CIPHER_ALGO_AES_256);
+}
+
 
 int main(int argc, char **argv)
 {
@@ -204,5 +283,18 @@ int main(int argc, char **argv)
     ADD_TESTS(16384);
     ADD_TESTS(65536);
 
+#define ADD_SECTOR_TEST(keysize, sector)                                \
+    if ((!alg || g_str_equal(alg, "sectors")) &&                        \
+        (!size || g_str_equal(size, #sector)))                          \
+        g_test_add_data_func(                                           \
+        "/crypto/cipher/sectors-xts-aes-" #keysize "/sector-" #sector,  \
+        (void *)sector,                                                 \
+        test_cipher_speed_sectors_xts_aes_ ## keysize)
+
+    ADD_SECTOR_TEST(128, 512);
+    ADD_SECTOR_TEST(256, 512);
+    ADD_SECTOR_TEST(128, 4096);
+    ADD_SECTOR_TEST(256, 4096);
+
     return g_test_run();
 }
@@ -0,0 +1,151 @@
+/*
+ * Measure the cost of marking guest writes dirty in a number of enabled
+ * dirty bitmaps, as bdrv_set_dirty() does for every write.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu/hbitmap.h"
+#include "qemu/timer.h"
+
+static const unsigned int default_n_bitmaps[] = { 1, 10, 50 };
+
+static unsigned int n_bitmaps;
+static unsigned int duration = 1;
+static uint64_t disk_size = 64ULL << 30;
+static int granularity = 16;            /* log2, i.e. 64 KiB */
+static uint64_t hot_size = 1ULL << 30;
+static uint64_t write_size = 4096;
+
+static const char commands_string[] =
+    " -n = number of bitmaps (default: run with 1, 10 and 50)\n"
+    " -d = duration of each run, in seconds\n"
+    " -s = disk size in MiB\n"
+    " -g = log2 of the bitmap granularity in bytes\n"
+    " -r = size in MiB of the area receiving the writes\n"
+    " -w = size in bytes of each write";
+
+static void usage_complete(char *argv[])
+{
+    fprintf(stderr, "Usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "options:\n%s\n", commands_string);
+}
+
+/*
+ * From: https://en.wikipedia.org/wiki/Xorshift
+ */
+static uint64_t xorshift64star(uint64_t x)
+{
+    x ^= x >> 12; /* a */
+    x ^= x << 25; /* b */
+    x ^= x >> 27; /* c */
+    return x * UINT64_C(2685821657736338717);
+}
+
+static void run(unsigned int n)
+{
+    HBitmap **bitmaps = g_new(HBitmap *, n);
+    uint64_t r = time(NULL) | 1;
+    uint64_t writes = 0;
+    int64_t start, now, end;
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        bitmaps[i] = hbitmap_alloc(disk_size, granularity);
+    }
+
+    start = get_clock();
+    end = start + duration * NANOSECONDS_PER_SECOND;
+    do {
+        int j;
+
+        for (j = 0; j < 1024; j++) {
+            uint64_t offset;
+
+            r = xorshift64star(r);
+            offset = QEMU_ALIGN_DOWN(r % (hot_size - write_size), 512);
+            for (i = 0; i < n; i++) {
+                hbitmap_set(bitmaps[i], offset, write_size);
+            }
+        }
+        writes += 1024;
+        now = get_clock();
+    } while (now < end);
+
+    printf(" %3u bitmaps: %8.2f Mwrites/s, %8.2f ns/write, %6.2f ns/bitmap\n",
+           n, (double)writes / ((now - start) / 1e9) / 1e6,
+           (double)(now - start) / writes,
+           (double)(now - start) / writes / n);
+
+    for (i = 0; i < n; i++) {
+        hbitmap_free(bitmaps[i]);
+    }
+    g_free(bitmaps);
+}
+
+static void pr_params(void)
+{
+    printf("Parameters:\n");
+    printf(" disk size:         %" PRIu64 " MiB\n", disk_size >> 20);
+    printf(" granularity:       %" PRIu64 " bytes\n", 1ULL << granularity);
+    printf(" write area:        %" PRIu64 " MiB\n", hot_size >> 20);
+    printf(" write size:        %" PRIu64 " bytes\n", write_size);
+    printf(" duration:          %u s per run\n", duration);
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    int c;
+
+    for (;;) {
+        c = getopt(argc, argv, "hd:g:n:r:s:w:");
+        if (c < 0) {
+            break;
+        }
+        switch (c) {
+        case 'h':
+            usage_complete(argv);
+            exit(0);
+        case 'd':
+            duration = atoi(optarg);
+            break;
+        case 'g':
+            granularity = atoi(optarg);
+            break;
+        case 'n':
+            n_bitmaps = atoi(optarg);
+            break;
+        case 'r':
+            hot_size = (uint64_t)atoll(optarg) << 20;
+            break;
+        case 's':
+            disk_size = (uint64_t)atoll(optarg) << 20;
+            break;
+        case 'w':
+            write_size = atoll(optarg);
+            break;
+        }
+    }
+    if (hot_size > disk_size || write_size == 0 || write_size >= hot_size) {
+        fprintf(stderr, "need 0 < write size < write area <= disk size\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int i;
+
+    parse_args(argc, argv);
+    pr_params();
+    printf("Results:\n");
+    if (n_bitmaps) {
+        run(n_bitmaps);
+    } else {
+        for (i = 0; i < ARRAY_SIZE(default_n_bitmaps); i++) {
+            run(default_n_bitmaps[i]);
+        }
+    }
+    return 0;
+}
@@ -33,7 +33,7 @@ struct thread_info {
      * and threshold = UINT64_MAX always match (100% hit).
      */
     uint64_t seed;
-    bool write_op; /* writes alternate between insertions and removals */
+    size_t n_updates; /* spreads insertions evenly among updates */
     bool resize_down;
 } QEMU_ALIGNED(64); /* avoid false sharing among threads */
 
@@ -64,6 +64,7 @@ static bool precompute_hash;
 
 static double update_rate; /* 0.0 to 1.0 */
 static uint64_t update_threshold;
+static uint64_t insert_ppm = 500000; /* insertions per million updates */
 static uint64_t resize_threshold;
 
 static size_t qht_n_elems = DEFAULT_QHT_N_ELEMS;
@@ -88,7 +89,8 @@ static const char commands_string[] =
     " -l = lookup range of keys (will be rounded up to pow2)\n"
     " -r = update range of keys (will be rounded up to pow2)\n"
     "\n"
-    " -u = update rate (0.0 to 100.0), 50/50 split of insertions/removals\n"
+    " -u = update rate (0.0 to 100.0)\n"
+    " -i = insertion rate (0.0 to 100.0) among updates; default 50\n"
     "\n"
     " -R = enable auto-resize\n"
     " -S = resize rate (0.0 to 100.0)\n"
@@ -156,6 +158,18 @@ static void do_rz(struct thread_info *info)
     g_usleep(resize_delay);
 }
 
+/*
+ * With the default 50% insertion rate, updates strictly alternate between
+ * insertions and removals, starting with an insertion.
+ */
+static bool update_is_insert(struct thread_info *info)
+{
+    size_t n = info->n_updates++;
+
+    return DIV_ROUND_UP((n + 1) * insert_ppm, 1000000) >
+           DIV_ROUND_UP(n * insert_ppm, 1000000);
+}
+
 static void do_rw(struct thread_info *info)
 {
     struct thread_stats *stats = &info->stats;
@@ -177,7 +191,7 @@ static void do_rw(struct thread_info *info)
     } else {
         p = &keys[r & (update_range - 1)];
         hash = hfunc(*p);
-        if (info->write_op) {
+        if (update_is_insert(info)) {
             bool written = false;
 
             if (qht_lookup(&ht, p, hash) == NULL) {
@@ -200,7 +214,6 @@ static void do_rw(struct thread_info *info)
                 stats->not_rm++;
             }
         }
-        info->write_op = !info->write_op;
     }
 }
 
@@ -231,8 +244,8 @@ static void prepare_thread_info(struct thread_info *info, int i)
 {
     /* seed for the RNG; each thread should have a different one */
     info->seed = (i + 1) ^ time(NULL);
-    /* the first update will be a write */
-    info->write_op = true;
+    /* the first update will be an insertion */
+    info->n_updates = 0;
     /* the first resize will be down */
     info->resize_down = true;
 
@@ -282,6 +295,7 @@ static void pr_params(void)
         printf(" # resize threads   %u\n", n_rz_threads);
     }
     printf(" update rate:       %f%%\n", update_rate * 100.0);
+    printf(" insertion rate:    %f%%\n", insert_ppm / 1e4);
     printf(" offset:            %ld\n", populate_offset);
     printf(" initial key range: %zu\n", init_range);
     printf(" lookup range:      %lu\n", lookup_range);
@@ -445,7 +459,7 @@ static void parse_args(int argc, char *argv[])
     int c;
 
     for (;;) {
-        c = getopt(argc, argv, "d:D:g:k:K:l:hn:N:o:pr:Rs:S:u:");
+        c = getopt(argc, argv, "d:D:g:i:k:K:l:hn:N:o:pr:Rs:S:u:");
         if (c < 0) {
             break;
         }
@@ -466,6 +480,9 @@ static void parse_args(int argc, char *argv[])
         case 'h':
             usage_complete(argc, argv);
             exit(0);
+        case 'i':
+            insert_ppm = MIN(MAX(atof(optarg), 0.0), 100.0) * 1e4;
+            break;
         case 'k':
             init_size = atol(optarg);
             break;
@@ -0,0 +1,199 @@
+/*
+ * Measure synchronize_rcu() latency against the number of RCU readers
+ * and of concurrent updaters.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu/thread.h"
+#include "qemu/processor.h"
+#include "qemu/rcu.h"
+#include "qemu/timer.h"
+
+struct thread_stats {
+    uint64_t ops;
+    uint64_t ns;
+    uint64_t max_ns;
+} QEMU_ALIGNED(64);
+
+static QemuThread *threads;
+static struct thread_stats *reader_stats;
+static struct thread_stats *updater_stats;
+static unsigned int n_readers = 1;
+static unsigned int n_updaters = 1;
+static unsigned int n_ready_threads;
+static unsigned int duration = 1;
+static unsigned int read_len;
+static bool test_start;
+static bool test_stop;
+
+static const char commands_string[] =
+    " -n = number of reader threads\n"
+    " -u = number of updater threads calling synchronize_rcu()\n"
+    " -l = iterations spent inside each read-side critical section\n"
+    " -d = duration in seconds";
+
+static void usage_complete(char *argv[])
+{
+    fprintf(stderr, "Usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "options:\n%s\n", commands_string);
+}
+
+static void wait_for_start(void)
+{
+    rcu_register_thread();
+    qatomic_inc(&n_ready_threads);
+    while (!qatomic_read(&test_start)) {
+        cpu_relax();
+    }
+}
+
+static void *reader_func(void *arg)
+{
+    struct thread_stats *stats = arg;
+    uint64_t ops = 0;
+
+    wait_for_start();
+
+    while (!qatomic_read(&test_stop)) {
+        unsigned int i;
+
+        rcu_read_lock();
+        for (i = 0; i < read_len; i++) {
+            cpu_relax();
+        }
+        rcu_read_unlock();
+        ops++;
+    }
+    stats->ops = ops;
+
+    rcu_unregister_thread();
+    return NULL;
+}
+
+static void *updater_func(void *arg)
+{
+    struct thread_stats *stats = arg;
+
+    wait_for_start();
+
+    while (!qatomic_read(&test_stop)) {
+        int64_t t = get_clock();
+        uint64_t delta;
+
+        synchronize_rcu();
+        delta = get_clock() - t;
+        stats->ns += delta;
+        stats->max_ns = MAX(stats->max_ns, delta);
+        stats->ops++;
+    }
+
+    rcu_unregister_thread();
+    return NULL;
+}
+
+static void create_threads(void)
+{
+    unsigned int i;
+
+    threads = g_new(QemuThread, n_readers + n_updaters);
+    reader_stats = g_new0(struct thread_stats, n_readers);
+    updater_stats = g_new0(struct thread_stats, n_updaters);
+
+    for (i = 0; i < n_readers; i++) {
+        qemu_thread_create(&threads[i], NULL, reader_func, &reader_stats[i],
+                           QEMU_THREAD_JOINABLE);
+    }
+    for (i = 0; i < n_updaters; i++) {
+        qemu_thread_create(&threads[n_readers + i], NULL, updater_func,
+                           &updater_stats[i], QEMU_THREAD_JOINABLE);
+    }
+}
+
+static void run_test(void)
+{
+    unsigned int i;
+
+    while (qatomic_read(&n_ready_threads) != n_readers + n_updaters) {
+        cpu_relax();
+    }
+
+    qatomic_set(&test_start, true);
+    g_usleep(duration * G_USEC_PER_SEC);
+    qatomic_set(&test_stop, true);
+
+    for (i = 0; i < n_readers + n_updaters; i++) {
+        qemu_thread_join(&threads[i]);
+    }
+}
+
+static void pr_params(void)
+{
+    printf("Parameters:\n");
+    printf(" # of readers:      %u\n", n_readers);
+    printf(" # of updaters:     %u\n", n_updaters);
+    printf(" read-side length:  %u\n", read_len);
+    printf(" duration:          %u\n", duration);
+}
+
+static void pr_stats(void)
+{
+    uint64_t reads = 0, syncs = 0, ns = 0, max_ns = 0;
+    unsigned int i;
+
+    for (i = 0; i < n_readers; i++) {
+        reads += reader_stats[i].ops;
+    }
+    for (i = 0; i < n_updaters; i++) {
+        syncs += updater_stats[i].ops;
+        ns += updater_stats[i].ns;
+        max_ns = MAX(max_ns, updater_stats[i].max_ns);
+    }
+
+    printf("Results:\n");
+    printf(" Reads:              %.2f Mops/s\n", (double)reads / duration / 1e6);
+    printf(" synchronize_rcu():  %.2f Kops/s\n", (double)syncs / duration / 1e3);
+    printf(" Avg latency:        %.2f us\n",
+           syncs ? (double)ns / syncs / 1e3 : 0.0);
+    printf(" Max latency:        %.2f us\n", (double)max_ns / 1e3);
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    int c;
+
+    for (;;) {
+        c = getopt(argc, argv, "hd:l:n:u:");
+        if (c < 0) {
+            break;
+        }
+        switch (c) {
+        case 'h':
+            usage_complete(argv);
+            exit(0);
+        case 'd':
+            duration = atoi(optarg);
+            break;
+        case 'l':
+            read_len = atoi(optarg);
+            break;
+        case 'n':
+            n_readers = atoi(optarg);
+            break;
+        case 'u':
+            n_updaters = atoi(optarg);
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    pr_params();
+    create_threads();
+    run_test();
+    pr_stats();
+    return 0;
+}
@@ -0,0 +1,334 @@
+/*
+ * fp-test-batch.c - check QEMU's batched softfloat operations
+ *
+ * float{32,64}_{add,sub,mul}_n() must produce the same results and the
+ * same accumulated exception flags as calling the scalar function for
+ * each lane in turn.  Run both on random and edge-case vectors under
+ * every rounding mode, with and without flush-to-zero, and compare.
+ *
+ * License: GNU GPL, version 2 or later.
+ *   See the COPYING file in the top-level directory.
+ */
+#ifndef HW_POISON_H
+#error Must define HW_POISON_H to work around TARGET_* poisoning
+#endif
+
+#include "qemu/osdep.h"
+#include "fpu/softfloat.h"
+
+/* more than a few chunks of the batched implementation */
+#define MAX_LANES 70
+
+static int errors;
+static uint64_t rand_state = 0x2545f4914f6cdd1dULL;
+
+/*
+ * From: https://en.wikipedia.org/wiki/Xorshift
+ */
+static uint64_t rand64(void)
+{
+    uint64_t x = rand_state;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rand_state = x;
+    return x * UINT64_C(2685821657736338717);
+}
+
+static const uint32_t f32_special[] = {
+    0x00000000, 0x80000000,             /* zeros */
+    0x3f800000, 0xbf800000,             /* +-1 */
+    0x00000001, 0x807fffff,             /* denormals */
+    0x00800000, 0x80800001,             /* smallest normals */
+    0x7f7fffff, 0xff7fffff,             /* largest normals */
+    0x7e800000,                         /* overflows when doubled */
+    0x7f800000, 0xff800000,             /* infinities */
+    0x7fc00000, 0xffc00001,             /* quiet NaNs */
+    0x7f800001, 0xffa00000,             /* signaling NaNs */
+};
+
+static const uint64_t f64_special[] = {
+    0x0000000000000000ULL, 0x8000000000000000ULL,
+    0x3ff0000000000000ULL, 0xbff0000000000000ULL,
+    0x0000000000000001ULL, 0x800fffffffffffffULL,
+    0x0010000000000000ULL, 0x8010000000000001ULL,
+    0x7fefffffffffffffULL, 0xffefffffffffffffULL,
+    0x7fd0000000000000ULL,
+    0x7ff0000000000000ULL, 0xfff0000000000000ULL,
+    0x7ff8000000000000ULL, 0xfff8000000000001ULL,
+    0x7ff0000000000001ULL, 0xfff4000000000000ULL,
+};
+
+/* A normal number close to 1.0, for which the host FPU path is taken */
+static uint32_t f32_benign(void)
+{
+    uint64_t r = rand64();
+    uint32_t exp = 127 - 20 + (r >> 32) % 41;
+
+    return (r & 0x807fffff) | (exp << 23);
+}
+
+static uint64_t f64_benign(void)
+{
+    uint64_t r = rand64();
+    uint64_t exp = 1023 - 40 + (r >> 52) % 81;
+
+    return (r & 0x800fffffffffffffULL) | (exp << 52);
+}
+
+static uint32_t f32_any(void)
+{
+    switch (rand64() % 4) {
+    case 0:
+        return f32_special[rand64() % ARRAY_SIZE(f32_special)];
+    case 1:
+        return rand64();
+    default:
+        return f32_benign();
+    }
+}
+
+static uint64_t f64_any(void)
+{
+    switch (rand64() % 4) {
+    case 0:
+        return f64_special[rand64() % ARRAY_SIZE(f64_special)];
+    case 1:
+        return rand64();
+    default:
+        return f64_benign();
+    }
+}
+
+typedef float32 (*f32_op_fn)(float32, float32, float_status *);
+typedef void (*f32_op_n_fn)(float32 *, const float32 *, const float32 *,
+                            size_t, float_status *);
+typedef float64 (*f64_op_fn)(float64, float64, float_status *);
+typedef void (*f64_op_n_fn)(float64 *, const float64 *, const float64 *,
+                            size_t, float_status *);
+
+static const struct {
+    const char *name;
+    f32_op_fn op;
+    f32_op_n_fn op_n;
+} f32_ops[] = {
+    { "f32_add", float32_add, float32_add_n },
+    { "f32_sub", float32_sub, float32_sub_n },
+    { "f32_mul", float32_mul, float32_mul_n },
+};
+
+static const struct {
+    const char *name;
+    f64_op_fn op;
+    f64_op_n_fn op_n;
+} f64_ops[] = {
+    { "f64_add", float64_add, float64_add_n },
+    { "f64_sub", float64_sub, float64_sub_n },
+    { "f64_mul", float64_mul, float64_mul_n },
+};
+
+static void report(const char *name, const float_status *s, size_t n,
+                   size_t lane, uint64_t a, uint64_t b,
+                   uint64_t expected, uint64_t got,
+                   int expected_flags, int got_flags)
+{
+    printf("%s: n=%zu round=%d ftz=%d fiz=%d flags_in=%#x\n",
+           name, n, get_float_rounding_mode(s), get_flush_to_zero(s),
+           get_flush_inputs_to_zero(s), get_float_exception_flags(s));
+    if (lane < n) {
+        printf("  lane %zu: %#" PRIx64 " op %#" PRIx64 ": expected %#"
+               PRIx64 ", got %#" PRIx64 "\n", lane, a, b, expected, got);
+    } else {
+        printf("  flags: expected %#x, got %#x\n", expected_flags, got_flags);
+    }
+    if (++errors == 20) {
+        exit(1);
+    }
+}
+
+static void f32_check(const float_status *init, const float32 *a,
+                      const float32 *b, size_t n)
+{
+    float32 expected[MAX_LANES], got[MAX_LANES];
+    size_t i, k;
+
+    for (k = 0; k < ARRAY_SIZE(f32_ops); k++) {
+        float_status s_scalar = *init, s_batch = *init;
+
+        for (i = 0; i < n; i++) {
+            expected[i] = f32_ops[k].op(a[i], b[i], &s_scalar);
+        }
+        f32_ops[k].op_n(got, a, b, n, &s_batch);
+
+        for (i = 0; i < n; i++) {
+            if (float32_val(expected[i]) != float32_val(got[i])) {
+                report(f32_ops[k].name, init, n, i,
+                       float32_val(a[i]), float32_val(b[i]),
+                       float32_val(expected[i]), float32_val(got[i]), 0, 0);
+                break;
+            }
+        }
+        if (get_float_exception_flags(&s_scalar) !=
+            get_float_exception_flags(&s_batch)) {
+            report(f32_ops[k].name, init, n, n, 0, 0, 0, 0,
+                   get_float_exception_flags(&s_scalar),
+                   get_float_exception_flags(&s_batch));
+        }
+
+        /* the destination may alias the first operand */
+        s_batch = *init;
+        memcpy(got, a, n * sizeof(*got));
+        f32_ops[k].op_n(got, got, b, n, &s_batch);
+        if (memcmp(expected, got, n * sizeof(*got)) ||
+            get_float_exception_flags(&s_scalar) !=
+            get_float_exception_flags(&s_batch)) {
+            report(f32_ops[k].name, init, n, n, 0, 0, 0, 0,
+                   get_float_exception_flags(&s_scalar),
+                   get_float_exception_flags(&s_batch));
+        }
+    }
+}
+
+static void f64_check(const float_status *init, const float64 *a,
+                      const float64 *b, size_t n)
+{
+    float64 expected[MAX_LANES], got[MAX_LANES];
+    size_t i, k;
+
+    for (k = 0; k < ARRAY_SIZE(f64_ops); k++) {
+        float_status s_scalar = *init, s_batch = *init;
+
+        for (i = 0; i < n; i++) {
+            expected[i] = f64_ops[k].op(a[i], b[i], &s_scalar);
+        }
+        f64_ops[k].op_n(got, a, b, n, &s_batch);
+
+        for (i = 0; i < n; i++) {
+            if (float64_val(expected[i]) != float64_val(got[i])) {
+                report(f64_ops[k].name, init, n, i,
+                       float64_val(a[i]), float64_val(b[i]),
+                       float64_val(expected[i]), float64_val(got[i]), 0, 0);
+                break;
+            }
+        }
+        if (get_float_exception_flags(&s_scalar) !=
+            get_float_exception_flags(&s_batch)) {
+            report(f64_ops[k].name, init, n, n, 0, 0, 0, 0,
+                   get_float_exception_flags(&s_scalar),
+                   get_float_exception_flags(&s_batch));
+        }
+
+        s_batch = *init;
+        memcpy(got, a, n * sizeof(*got));
+        f64_ops[k].op_n(got, got, b, n, &s_batch);
+        if (memcmp(expected, got, n * sizeof(*got)) ||
+            get_float_exception_flags(&s_scalar) !=
+            get_float_exception_flags(&s_batch)) {
+            report(f64_ops[k].name, init, n, n, 0, 0, 0, 0,
+                   get_float_exception_flags(&s_scalar),
+                   get_float_exception_flags(&s_batch));
+        }
+    }
+}
+
+static void test_f32(const float_status *s)
+{
+    float32 a[MAX_LANES], b[MAX_LANES];
+    size_t i, j, n;
+
+    /* all lanes eligible for the host FPU */
+    for (n = 1; n <= MAX_LANES; n++) {
+        for (i = 0; i < n; i++) {
+            a[i] = make_float32(f32_benign());
+            b[i] = make_float32(f32_benign());
+        }
+        f32_check(s, a, b, n);
+    }
+
+    /* a single special lane in the middle of an otherwise benign chunk */
+    for (j = 0; j < ARRAY_SIZE(f32_special); j++) {
+        for (i = 0; i < MAX_LANES; i++) {
+            a[i] = make_float32(f32_benign());
+            b[i] = make_float32(f32_benign());
+        }
+        a[7] = make_float32(f32_special[j]);
+        b[16 + 9] = make_float32(f32_special[j]);
+        a[16 + 9] = make_float32(f32_special[rand64() %
+                                             ARRAY_SIZE(f32_special)]);
+        f32_check(s, a, b, MAX_LANES);
+    }
+
+    /* random mix of everything */
+    for (j = 0; j < 100; j++) {
+        n = 1 + rand64() % MAX_LANES;
+        for (i = 0; i < n; i++) {
+            a[i] = make_float32(f32_any());
+            b[i] = make_float32(f32_any());
+        }
+        f32_check(s, a, b, n);
+    }
+}
+
+static void test_f64(const float_status *s)
+{
+    float64 a[MAX_LANES], b[MAX_LANES];
+    size_t i, j, n;
+
+    for (n = 1; n <= MAX_LANES; n++) {
+        for (i = 0; i < n; i++) {
+            a[i] = make_float64(f64_benign());
+            b[i] = make_float64(f64_benign());
+        }
+        f64_check(s, a, b, n);
+    }
+
+    for (j = 0; j < ARRAY_SIZE(f64_special); j++) {
+        for (i = 0; i < MAX_LANES; i++) {
+            a[i] = make_float64(f64_benign());
+            b[i] = make_float64(f64_benign());
+        }
+        a[7] = make_float64(f64_special[j]);
+        b[16 + 9] = make_float64(f64_special[j]);
+        a[16 + 9] = make_float64(f64_special[rand64() %
+                                             ARRAY_SIZE(f64_special)]);
+        f64_check(s, a, b, MAX_LANES);
+    }
+
+    for (j = 0; j < 100; j++) {
+        n = 1 + rand64() % MAX_LANES;
+        for (i = 0; i < n; i++) {
+            a[i] = make_float64(f64_any());
+            b[i] = make_float64(f64_any());
+        }
+        f64_check(s, a, b, n);
+    }
+}
+
+int main(int ac, char **av)
+{
+    float_status qsf = {0};
+    int round, ftz, fiz, inexact;
+
+    set_float_2nan_prop_rule(float_2nan_prop_s_ab, &qsf);
+    set_float_default_nan_pattern(0b01000000, &qsf);
+
+    for (round = 0; round <= float_round_nearest_even_max; round++) {
+        for (ftz = 0; ftz < 2; ftz++) {
+            for (fiz = 0; fiz < 2; fiz++) {
+                /* the host FPU is only used once inexact has been raised */
+                for (inexact = 0; inexact < 2; inexact++) {
+                    set_float_rounding_mode(round, &qsf);
+                    set_flush_to_zero(ftz, &qsf);
+                    set_flush_inputs_to_zero(fiz, &qsf);
+                    set_float_exception_flags(inexact ? float_flag_inexact : 0,
+                                              &qsf);
+                    test_f32(&qsf);
+                    test_f64(&qsf);
+                }
+            }
+        }
+    }
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Masked-off elements of strided vector loads and stores must not be
+ * accessed, even when they fall into an unmapped page.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define N 8
+#define STRIDE 16
+
+static void vlse32_masked(uint32_t *out, const void *base, uint8_t mask)
+{
+    asm volatile("vsetivli zero, 8, e32, m1, ta, mu\n\t"
+                 "vlm.v v0, (%[mask])\n\t"
+                 "vmv.v.i v8, -1\n\t"
+                 "vlse32.v v8, (%[base]), %[stride], v0.t\n\t"
+                 "vse32.v v8, (%[out])\n\t"
+                 : : [mask] "r"(&mask), [base] "r"(base),
+                     [stride] "r"((long)STRIDE), [out] "r"(out)
+                 : "v0", "v8", "memory");
+}
+
+static void vsse32_masked(void *base, const uint32_t *in, uint8_t mask)
+{
+    asm volatile("vsetivli zero, 8, e32, m1, ta, mu\n\t"
+                 "vlm.v v0, (%[mask])\n\t"
+                 "vle32.v v8, (%[in])\n\t"
+                 "vsse32.v v8, (%[base]), %[stride], v0.t\n\t"
+                 : : [mask] "r"(&mask), [base] "r"(base),
+                     [stride] "r"((long)STRIDE), [in] "r"(in)
+                 : "v0", "v8", "memory");
+}
+
+int main(void)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    uint32_t in[N], out[N];
+    uint8_t *buf, *base;
+    int i;
+
+    buf = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(buf != MAP_FAILED);
+    assert(munmap(buf + page, page) == 0);
+
+    /* elements 0-3 are in the mapped page, elements 4-7 are not */
+    base = buf + page - 4 * STRIDE;
+    for (i = 0; i < 4; i++) {
+        *(uint32_t *)(base + i * STRIDE) = 0x100 + i;
+    }
+
+    vlse32_masked(out, base, 0x0f);
+    for (i = 0; i < N; i++) {
+        assert(out[i] == (i < 4 ? 0x100 + i : UINT32_MAX));
+    }
+
+    for (i = 0; i < N; i++) {
+        in[i] = 0x200 + i;
+    }
+    vsse32_masked(base, in, 0x05);
+    for (i = 0; i < 4; i++) {
+        assert(*(uint32_t *)(base + i * STRIDE) ==
+               (i % 2 ? 0x100 + i : 0x200 + i));
+    }
+
+    /* with every element masked off, nothing is accessed at all */
+    vlse32_masked(out, buf + page, 0);
+    vsse32_masked(buf + page, in, 0);
+
+    return 0;
+}
@@ -335,6 +335,19 @@ static void test_hbitmap_set_twice(TestHBitmapData *data,
     hbitmap_test_set(data, L1, 1);
 }
 
+static void test_hbitmap_set_within_word(TestHBitmapData *data,
+                                         const void *unused)
+{
+    hbitmap_test_init(data, L1 * 2, 0);
+    hbitmap_test_set(data, 3, 5);
+    hbitmap_test_set(data, 1, 10);
+    hbitmap_test_set(data, 4, 2);
+    hbitmap_test_set(data, L1 - 8, 8);
+    hbitmap_test_set(data, L1 - 1, 2);
+    hbitmap_test_set(data, L1, L1);
+    hbitmap_test_set(data, L1 + 7, 1);
+}
+
 static void test_hbitmap_set_overlap(TestHBitmapData *data,
                                      const void *unused)
 {
@@ -1058,6 +1071,7 @@ int main(int argc, char **argv)
     hbitmap_test_add("/hbitmap/set/two-elem", test_hbitmap_set_two_elem);
     hbitmap_test_add("/hbitmap/set/general", test_hbitmap_set);
     hbitmap_test_add("/hbitmap/set/twice", test_hbitmap_set_twice);
+    hbitmap_test_add("/hbitmap/set/within-word", test_hbitmap_set_within_word);
     hbitmap_test_add("/hbitmap/set/overlap", test_hbitmap_set_overlap);
     hbitmap_test_add("/hbitmap/reset/empty", test_hbitmap_reset_empty);
     hbitmap_test_add("/hbitmap/reset/general", test_hbitmap_reset);
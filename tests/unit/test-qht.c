@@ -7,6 +7,7 @@
 #include "qemu/osdep.h"
 #include "qemu/qht.h"
 #include "qemu/rcu.h"
+#include "qemu/thread.h"
 
 #define N 5000
 
@@ -241,6 +242,56 @@ static void qht_test(unsigned int mode)
     qht_do_test(mode, 16384);
 }
 
+static bool writer_done;
+
+/* churn [N, N * 2) and leave it inserted */
+static void *resize_writer_func(void *arg)
+{
+    int i;
+
+    rcu_register_thread();
+    for (i = 0; i < 200; i++) {
+        rcu_read_lock();
+        insert(N, N * 2);
+        rm(N, N * 2);
+        rcu_read_unlock();
+    }
+    rcu_read_lock();
+    insert(N, N * 2);
+    rcu_read_unlock();
+    rcu_unregister_thread();
+    qatomic_set(&writer_done, true);
+    return NULL;
+}
+
+/*
+ * Resize back and forth while another thread inserts and removes entries,
+ * so that writers hit both migrated and not-yet-migrated buckets.  Lost or
+ * duplicated entries would show up in the final count.
+ */
+static void test_resize_concurrent(void)
+{
+    QemuThread writer;
+    size_t n_resizes = 0;
+
+    qht_init(&ht, is_equal, N, 0);
+    insert(0, N);
+
+    qatomic_set(&writer_done, false);
+    qemu_thread_create(&writer, "qht-writer", resize_writer_func, NULL,
+                       QEMU_THREAD_JOINABLE);
+    while (!qatomic_read(&writer_done) || n_resizes < 2) {
+        qht_resize(&ht, n_resizes % 2 ? N * 4 : N / 8);
+        n_resizes++;
+    }
+    qemu_thread_join(&writer);
+
+    check(0, N * 2, true);
+    check_n(N * 2);
+    iter_check(N * 2);
+    qht_destroy(&ht);
+}
+
 static void test_default(void)
 {
     qht_test(0);
@@ -256,5 +307,6 @@ int main(int argc, char *argv[])
     g_test_init(&argc, &argv, NULL);
     g_test_add_func("/qht/mode/default", test_default);
     g_test_add_func("/qht/mode/resize", test_resize);
+    g_test_add_func("/qht/resize/concurrent", test_resize_concurrent);
     return g_test_run();
 }
@@ -3154,8 +3154,10 @@ static int vnc_refresh_server_surface(VncDisplay *vd)
     int has_dirty = 0;
     pixman_image_t *tmpbuf = NULL;
     unsigned long offset;
-    int x;
+    int x, x_end = DIV_ROUND_UP(width, VNC_DIRTY_PIXELS_PER_BIT);
     uint8_t *guest_ptr, *server_ptr;
+    DECLARE_BITMAP(changed, VNC_DIRTY_BITS);
+    bool row_changed;
 
     struct timeval tv = { 0, 0 };
 
@@ -3198,40 +3200,52 @@ static int vnc_refresh_server_surface(VncDisplay *vd)
         y = offset / VNC_DIRTY_BPL(&vd->guest);
         x = offset % VNC_DIRTY_BPL(&vd->guest);
 
-        server_ptr = server_row0 + y * server_stride + x * cmp_bytes;
-
         if (vd->guest.format != VNC_SERVER_FB_FORMAT) {
             qemu_pixman_linebuf_fill(tmpbuf, vd->guest.fb, width, 0, y);
             guest_ptr = (uint8_t *)pixman_image_get_data(tmpbuf);
         } else {
             guest_ptr = guest_row0 + y * guest_stride;
         }
-        guest_ptr += x * cmp_bytes;
 
-        for (; x < DIV_ROUND_UP(width, VNC_DIRTY_PIXELS_PER_BIT);
-             x++, guest_ptr += cmp_bytes, server_ptr += cmp_bytes) {
+        /*
+         * Only visit the dirty bits of the row, and collect the changed
+         * ones so that each client's dirty map is updated once per row
+         * rather than once per changed block.
+         */
+        row_changed = false;
+        for (x = find_next_bit(vd->guest.dirty[y], x_end, x); x < x_end;
+             x = find_next_bit(vd->guest.dirty[y], x_end, x + 1)) {
             int _cmp_bytes = cmp_bytes;
-            if (!test_and_clear_bit(x, vd->guest.dirty[y])) {
-                continue;
-            }
+
+            clear_bit(x, vd->guest.dirty[y]);
             if ((x + 1) * cmp_bytes > line_bytes) {
                 _cmp_bytes = line_bytes - x * cmp_bytes;
             }
             assert(_cmp_bytes >= 0);
-            if (memcmp(server_ptr, guest_ptr, _cmp_bytes) == 0) {
+            server_ptr = server_row0 + y * server_stride + x * cmp_bytes;
+            if (memcmp(server_ptr, guest_ptr + x * cmp_bytes,
+                       _cmp_bytes) == 0) {
                 continue;
             }
-            memcpy(server_ptr, guest_ptr, _cmp_bytes);
+            memcpy(server_ptr, guest_ptr + x * cmp_bytes, _cmp_bytes);
             if (!vd->non_adaptive) {
                 vnc_rect_updated(vd, x * VNC_DIRTY_PIXELS_PER_BIT,
                                  y, &tv);
             }
-            QTAILQ_FOREACH(vs, &vd->clients, next) {
-                set_bit(x, vs->dirty[y]);
+            if (!row_changed) {
+                bitmap_zero(changed, x_end);
+                row_changed = true;
             }
+            set_bit(x, changed);
             has_dirty++;
         }
 
+        if (row_changed) {
+            QTAILQ_FOREACH(vs, &vd->clients, next) {
+                bitmap_or(vs->dirty[y], vs->dirty[y], changed, x_end);
+            }
+        }
+
         y++;
         offset = find_next_bit((unsigned long *) &vd->guest.dirty,
                                height * VNC_DIRTY_BPL(&vd->guest),
@@ -496,6 +496,7 @@ static bool run_poll_handlers(AioContext *ctx, AioHandlerList *ready_list,
 {
     bool progress;
     int64_t start_time, elapsed_time;
+    int64_t poll_ns = max_ns;
 
     assert(qemu_lockcnt_count(&ctx->list_lock) > 0);
 
@@ -527,6 +528,17 @@ static bool run_poll_handlers(AioContext *ctx, AioHandlerList *ready_list,
         }
     } while (elapsed_time < max_ns);
 
+    /*
+     * Only count a failure when the whole polling time was used up, not
+     * when polling stopped early for a ready fd or a timer.
+     */
+    if (progress) {
+        qatomic_set(&ctx->poll_success, ctx->poll_success + 1);
+    } else if (elapsed_time >= poll_ns) {
+        qatomic_set(&ctx->poll_fail, ctx->poll_fail + 1);
+        qatomic_set(&ctx->poll_wasted_ns, ctx->poll_wasted_ns + elapsed_time);
+    }
+
     if (remove_idle_poll_handlers(ctx, ready_list,
                                   start_time + elapsed_time)) {
         *timeout = 0;
@@ -479,7 +479,27 @@ void hbitmap_set(HBitmap *hb, uint64_t start, uint64_t count)
     assert(last < hb->size);
     n = last - first + 1;
 
-    hb->count += n - hb_count_between(hb, first, last);
+    if ((first >> BITS_PER_LEVEL) == (last >> BITS_PER_LEVEL)) {
+        /*
+         * Fast path for ranges within a single word of the last level,
+         * which is what most guest writes look like.  Count the new bits
+         * directly, and return early if they were all set already: this
+         * keeps repeated writes to hot areas cheap even with many enabled
+         * dirty bitmaps.
+         */
+        unsigned long elem =
+            hb->levels[HBITMAP_LEVELS - 1][first >> BITS_PER_LEVEL];
+        unsigned long mask = (2UL << (last & (BITS_PER_LONG - 1))) -
+                             (1UL << (first & (BITS_PER_LONG - 1)));
+
+        if (!(mask & ~elem)) {
+            return;
+        }
+        hb->count += ctpopl(mask & ~elem);
+    } else {
+        hb->count += n - hb_count_between(hb, first, last);
+    }
+
     if (hb_set_between(hb, HBITMAP_LEVELS - 1, first, last) &&
         hb->meta) {
         hbitmap_set(hb->meta, start, count);
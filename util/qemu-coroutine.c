@@ -67,6 +67,12 @@ static unsigned int global_pool_max_size = COROUTINE_POOL_BATCH_MAX_SIZE;
 QEMU_DEFINE_STATIC_CO_TLS(CoroutinePool, local_pool);
 QEMU_DEFINE_STATIC_CO_TLS(Notifier, local_pool_cleanup_notifier);
 
+/* Pool statistics, see qemu_coroutine_get_pool_stats() */
+static uint64_t pool_hits;
+static uint64_t pool_misses;
+static uint64_t pool_discarded;
+QEMU_DEFINE_STATIC_CO_TLS(unsigned int, local_pool_hits);
+
 static CoroutinePoolBatch *coroutine_pool_batch_new(void)
 {
     CoroutinePoolBatch *batch = g_new(CoroutinePoolBatch, 1);
@@ -147,6 +153,8 @@ static void coroutine_pool_refill_local(void)
         }
     }
 
+    trace_qemu_coroutine_pool_refill(batch ? batch->size : 0);
+
     if (batch) {
         QSLIST_INSERT_HEAD(local_pool, batch, next);
         local_pool_cleanup_init_once();
@@ -170,6 +178,8 @@ static void coroutine_pool_put_global(CoroutinePoolBatch *batch)
     }
 
     /* The global pool was full, so throw away this batch */
+    trace_qemu_coroutine_pool_discard(batch->size);
+    qatomic_add(&pool_discarded, batch->size);
     coroutine_pool_batch_delete(batch);
 }
 
@@ -186,6 +196,20 @@ static Coroutine *coroutine_pool_get(void)
     return co;
 }
 
+/*
+ * Hits are counted per thread and added to the global counter once per
+ * batch, so that the fast path does not touch a shared cache line.
+ */
+static void coroutine_pool_count_hit(void)
+{
+    unsigned int *hits = get_ptr_local_pool_hits();
+
+    if (++*hits == COROUTINE_POOL_BATCH_MAX_SIZE) {
+        qatomic_add(&pool_hits, *hits);
+        *hits = 0;
+    }
+}
+
 static void coroutine_pool_put(Coroutine *co)
 {
     CoroutinePool *local_pool = get_ptr_local_pool();
@@ -220,10 +244,15 @@ Coroutine *qemu_coroutine_create(CoroutineEntry *entry, void *opaque)
 
     if (IS_ENABLED(CONFIG_COROUTINE_POOL)) {
         co = coroutine_pool_get();
+        if (co) {
+            coroutine_pool_count_hit();
+        }
     }
 
     if (!co) {
         co = qemu_coroutine_new();
+        trace_qemu_coroutine_pool_miss(co);
+        qatomic_inc(&pool_misses);
     }
 
     co->entry = entry;
@@ -361,6 +390,14 @@ void qemu_coroutine_dec_pool_size(unsigned int removing_pool_size)
     global_pool_max_size -= removing_pool_size;
 }
 
+void qemu_coroutine_get_pool_stats(uint64_t *hits, uint64_t *misses,
+                                   uint64_t *discarded)
+{
+    *hits = qatomic_read(&pool_hits);
+    *misses = qatomic_read(&pool_misses);
+    *discarded = qatomic_read(&pool_discarded);
+}
+
 static unsigned int get_global_pool_hard_max_size(void)
 {
 #ifdef __linux__
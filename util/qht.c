@@ -23,7 +23,7 @@
  *   different buckets; writes to the same bucket are serialized through a lock.
  * - Optional auto-resizing: the hash table resizes up if the load surpasses
  *   a certain threshold. Resizing is done concurrently with readers; writes
- *   are serialized with the resize operation.
+ *   are only serialized with the migration of the bucket they touch.
  *
  * The key structure is the bucket, which is cacheline-sized. Buckets
  * contain a few hash values and pointers; the u32 hash values are stored in
@@ -43,10 +43,15 @@
  * just-removed entry. This makes lookups slightly faster, since the moment an
  * invalid entry is found, the (failed) lookup is over.
  *
- * Resizing is done by taking all bucket spinlocks (so that no other writers can
- * race with us) and then copying all entries into a new hash map. Then, the
+ * Resizing is done one head bucket at a time: with ht->lock held, each bucket
+ * of the old map is locked, its entries are copied into the new map, and the
+ * bucket is marked as migrated before it is unlocked again. Readers keep using
+ * the old map, which remains complete throughout. Writers that lock an
+ * already-migrated bucket mirror their update into the new map, so that once
+ * every bucket has been migrated the new map is complete as well. Then, the
  * ht->map pointer is set, and the old map is freed once no RCU readers can see
- * it anymore.
+ * it anymore. Resets and removing iterations take ht->lock so that they
+ * cannot race with a migration.
  *
  * Writers check for concurrent resizes by comparing ht->map before and after
  * acquiring their bucket lock. If they don't match, a resize has occurred
@@ -70,6 +75,7 @@
 #include "qemu/atomic.h"
 #include "qemu/rcu.h"
 #include "qemu/memalign.h"
+#include "qemu/bitmap.h"
 
 //#define QHT_DEBUG
 
@@ -176,6 +182,10 @@ struct qht_tsan_lock {
  * @n_added_buckets: number of added (i.e. "non-head") buckets
  * @n_added_buckets_threshold: threshold to trigger an upward resize once the
  *                             number of added buckets surpasses it.
+ * @new_map: map this map is being migrated to, or NULL if no resize is
+ *           in progress. Set with ht->lock held.
+ * @migrated: bitmap of the head buckets that have already been copied to
+ *            @new_map. Each bit is set with its bucket's lock held.
  * @tsan_bucket_locks: Array of striped locks to be used only under TSAN.
  *
  * Buckets are tracked in what we call a "map", i.e. this structure.
@@ -186,6 +196,8 @@ struct qht_map {
     size_t n_buckets;
     size_t n_added_buckets;
     size_t n_added_buckets_threshold;
+    struct qht_map *new_map;
+    unsigned long *migrated;
 #ifdef CONFIG_TSAN
     struct qht_tsan_lock tsan_bucket_locks[QHT_TSAN_BUCKET_LOCKS];
 #endif
@@ -196,6 +208,7 @@ struct qht_map {
 
 static void qht_do_resize_reset(struct qht *ht, struct qht_map *new,
                                 bool reset);
+static void qht_do_resize(struct qht *ht, struct qht_map *new);
 static void qht_grow_maybe(struct qht *ht);
 
 #ifdef QHT_DEBUG
@@ -341,34 +354,6 @@ static inline bool qht_map_is_stale__locked(const struct qht *ht,
     return map != ht->map;
 }
 
-/*
- * Grab all bucket locks, and set @pmap after making sure the map isn't stale.
- *
- * Pairs with qht_map_unlock_buckets(), hence the pass-by-reference.
- *
- * Note: callers cannot have ht->lock held.
- */
-static inline
-void qht_map_lock_buckets__no_stale(struct qht *ht, struct qht_map **pmap)
-{
-    struct qht_map *map;
-
-    map = qatomic_rcu_read(&ht->map);
-    qht_map_lock_buckets(map);
-    if (likely(!qht_map_is_stale__locked(ht, map))) {
-        *pmap = map;
-        return;
-    }
-    qht_map_unlock_buckets(map);
-
-    /* we raced with a resize; acquire ht->lock to see the updated ht->map */
-    qht_lock(ht);
-    map = ht->map;
-    qht_map_lock_buckets(map);
-    qht_unlock(ht);
-    *pmap = map;
-}
-
 /*
  * Get a head bucket and lock it, making sure its parent map is not stale.
  * @pmap is filled with a pointer to the bucket's parent map.
@@ -410,6 +395,25 @@ static inline bool qht_map_needs_resize(const struct qht_map *map)
            map->n_added_buckets_threshold;
 }
 
+/*
+ * Call with @head's lock held.
+ * If @head has already been copied to the map that @map is being resized to,
+ * return that map; updates to @head must then be mirrored there.
+ */
+static inline
+struct qht_map *qht_map_migrated__locked(const struct qht_map *map,
+                                         const struct qht_bucket *head)
+{
+    /* pairs with the store-release in qht_do_resize() */
+    struct qht_map *new = qatomic_load_acquire(&map->new_map);
+
+    if (likely(new == NULL) ||
+        !test_bit(head - map->buckets, map->migrated)) {
+        return NULL;
+    }
+    return new;
+}
+
 static inline void qht_chain_destroy(struct qht_map *map,
                                      struct qht_bucket *head)
 {
@@ -433,6 +437,7 @@ static void qht_map_destroy(struct qht_map *map)
         qht_chain_destroy(map, &map->buckets[i]);
     }
     qemu_vfree(map->buckets);
+    g_free(map->migrated);
     g_free(map);
 }
 
@@ -445,6 +450,8 @@ static struct qht_map *qht_map_create(size_t n_buckets)
     map->n_buckets = n_buckets;
 
     map->n_added_buckets = 0;
+    map->new_map = NULL;
+    map->migrated = NULL;
     map->n_added_buckets_threshold = n_buckets /
         QHT_NR_ADDED_BUCKETS_THRESHOLD_DIV;
 
@@ -517,14 +524,13 @@ void qht_reset(struct qht *ht)
 {
     struct qht_map *map;
 
-    qht_map_lock_buckets__no_stale(ht, &map);
+    /* serialize with resizes, which would otherwise keep the entries */
+    qht_lock(ht);
+    map = ht->map;
+    qht_map_lock_buckets(map);
     qht_map_reset__all_locked(map);
     qht_map_unlock_buckets(map);
-}
-
-static inline void qht_do_resize(struct qht *ht, struct qht_map *new)
-{
-    qht_do_resize_reset(ht, new, false);
+    qht_unlock(ht);
 }
 
 static inline void qht_do_resize_and_reset(struct qht *ht, struct qht_map *new)
@@ -695,6 +701,7 @@ bool qht_insert(struct qht *ht, void *p, uint32_t hash, void **existing)
 {
     struct qht_bucket *b;
     struct qht_map *map;
+    struct qht_map *new;
     bool needs_resize = false;
     void *prev;
 
@@ -703,6 +710,14 @@ bool qht_insert(struct qht *ht, void *p, uint32_t hash, void **existing)
 
     b = qht_bucket_lock__no_stale(ht, hash, &map);
     prev = qht_insert__locked(ht, map, b, p, hash, &needs_resize);
+    new = qht_map_migrated__locked(map, b);
+    if (unlikely(new) && prev == NULL) {
+        struct qht_bucket *nb = qht_map_to_bucket(new, hash);
+
+        qht_bucket_lock(new, nb);
+        qht_insert__locked(ht, new, nb, p, hash, NULL);
+        qht_bucket_unlock(new, nb);
+    }
     qht_bucket_debug__locked(b);
     qht_bucket_unlock(map, b);
 
@@ -807,6 +822,7 @@ bool qht_remove(struct qht *ht, const void *p, uint32_t hash)
 {
     struct qht_bucket *b;
     struct qht_map *map;
+    struct qht_map *new;
     bool ret;
 
     /* NULL pointers are not supported */
@@ -814,6 +830,14 @@ bool qht_remove(struct qht *ht, const void *p, uint32_t hash)
 
     b = qht_bucket_lock__no_stale(ht, hash, &map);
     ret = qht_remove__locked(b, p, hash);
+    new = qht_map_migrated__locked(map, b);
+    if (unlikely(new) && ret) {
+        struct qht_bucket *nb = qht_map_to_bucket(new, hash);
+
+        qht_bucket_lock(new, nb);
+        qht_remove__locked(nb, p, hash);
+        qht_bucket_unlock(new, nb);
+    }
     qht_bucket_debug__locked(b);
     qht_bucket_unlock(map, b);
     return ret;
@@ -871,10 +895,17 @@ do_qht_iter(struct qht *ht, const struct qht_iter *iter, void *userp)
 {
     struct qht_map *map;
 
+    /* removals must not race with a resize; see qht_do_resize() */
+    if (iter->type == QHT_ITER_RM) {
+        qht_lock(ht);
+    }
     map = qatomic_rcu_read(&ht->map);
     qht_map_lock_buckets(map);
     qht_map_iter__all_locked(map, iter, userp);
     qht_map_unlock_buckets(map);
+    if (iter->type == QHT_ITER_RM) {
+        qht_unlock(ht);
+    }
 }
 
 void qht_iter(struct qht *ht, qht_iter_func_t func, void *userp)
@@ -913,6 +944,55 @@ static void qht_map_copy(void *p, uint32_t hash, void *userp)
     qht_insert__locked(ht, new, b, p, hash, NULL);
 }
 
+static void qht_map_copy__locked(void *p, uint32_t hash, void *userp)
+{
+    struct qht_map_copy_data *data = userp;
+    struct qht *ht = data->ht;
+    struct qht_map *new = data->new;
+    struct qht_bucket *b = qht_map_to_bucket(new, hash);
+
+    /* writers to already-migrated buckets may be inserting into @new */
+    qht_bucket_lock(new, b);
+    qht_insert__locked(ht, new, b, p, hash, NULL);
+    qht_bucket_unlock(new, b);
+}
+
+/*
+ * Migrate all entries to @new one head bucket at a time, so that writers are
+ * only held off while the bucket they are after is being copied.
+ * Call with ht->lock held.
+ */
+static void qht_do_resize(struct qht *ht, struct qht_map *new)
+{
+    struct qht_map *old = ht->map;
+    const struct qht_iter iter = {
+        .f.retvoid = qht_map_copy__locked,
+        .type = QHT_ITER_VOID,
+    };
+    struct qht_map_copy_data data = {
+        .ht = ht,
+        .new = new,
+    };
+    size_t i;
+
+    g_assert(new->n_buckets != old->n_buckets);
+    old->migrated = bitmap_new(old->n_buckets);
+    /* writers must see the zeroed bitmap before they can see @new */
+    qatomic_store_release(&old->new_map, new);
+
+    for (i = 0; i < old->n_buckets; i++) {
+        struct qht_bucket *b = &old->buckets[i];
+
+        qht_bucket_lock(old, b);
+        qht_bucket_iter(b, &iter, &data);
+        set_bit_atomic(i, old->migrated);
+        qht_bucket_unlock(old, b);
+    }
+
+    qatomic_rcu_set(&ht->map, new);
+    call_rcu(old, qht_map_destroy, rcu);
+}
+
 /*
  * Atomically perform a resize and/or reset.
  * Call with ht->lock held.
@@ -54,6 +54,12 @@ static int rcu_call_count;
 static QemuMutex rcu_registry_lock;
 static QemuMutex rcu_sync_lock;
 
+/*
+ * Grace period sequence number.  It is odd while a grace period is in
+ * progress and is only written with rcu_sync_lock held.
+ */
+static unsigned long rcu_gp_seq;
+
 /*
  * Check whether a quiescent state was crossed between the beginning of
  * update_counter_and_wait and now.
@@ -173,8 +179,29 @@ static void wait_for_readers(void)
 
 void synchronize_rcu(void)
 {
+    unsigned long snap;
+
+    /* Write RCU-protected pointers before sampling rcu_gp_seq.  */
+    smp_mb();
+
+    /*
+     * The grace period we need is the first one that starts after this
+     * point.  If one is in progress, that is the one after it.
+     */
+    snap = (qatomic_read(&rcu_gp_seq) + 3) & ~1UL;
+
     QEMU_LOCK_GUARD(&rcu_sync_lock);
 
+    /*
+     * If another thread completed a full grace period while we were waiting
+     * for rcu_sync_lock, share it instead of starting our own.  This way,
+     * any number of concurrent callers costs at most two grace periods.
+     */
+    if ((long)(rcu_gp_seq - snap) >= 0) {
+        return;
+    }
+    qatomic_set(&rcu_gp_seq, rcu_gp_seq + 1);
+
     /* Write RCU-protected pointers before reading p_rcu_reader->ctr.
      * Pairs with smp_mb_placeholder() in rcu_read_lock().
      *
@@ -183,24 +210,27 @@ void synchronize_rcu(void)
      */
     smp_mb_global();
 
-    QEMU_LOCK_GUARD(&rcu_registry_lock);
-    if (!QLIST_EMPTY(&registry)) {
-        if (sizeof(rcu_gp_ctr) < 8) {
-            /* For architectures with 32-bit longs, a two-subphases algorithm
-             * ensures we do not encounter overflow bugs.
-             *
-             * Switch parity: 0 -> 1, 1 -> 0.
-             */
-            qatomic_set(&rcu_gp_ctr, rcu_gp_ctr ^ RCU_GP_CTR);
+    WITH_QEMU_LOCK_GUARD(&rcu_registry_lock) {
+        if (!QLIST_EMPTY(&registry)) {
+            if (sizeof(rcu_gp_ctr) < 8) {
+                /* For architectures with 32-bit longs, a two-subphases
+                 * algorithm ensures we do not encounter overflow bugs.
+                 *
+                 * Switch parity: 0 -> 1, 1 -> 0.
+                 */
+                qatomic_set(&rcu_gp_ctr, rcu_gp_ctr ^ RCU_GP_CTR);
+                wait_for_readers();
+                qatomic_set(&rcu_gp_ctr, rcu_gp_ctr ^ RCU_GP_CTR);
+            } else {
+                /* Increment current grace period.  */
+                qatomic_set(&rcu_gp_ctr, rcu_gp_ctr + RCU_GP_CTR);
+            }
+
             wait_for_readers();
-            qatomic_set(&rcu_gp_ctr, rcu_gp_ctr ^ RCU_GP_CTR);
-        } else {
-            /* Increment current grace period.  */
-            qatomic_set(&rcu_gp_ctr, rcu_gp_ctr + RCU_GP_CTR);
         }
-
-        wait_for_readers();
     }
+
+    qatomic_set(&rcu_gp_seq, rcu_gp_seq + 1);
 }
 
 /* Multi-producer, single-consumer queue based on urcu/static/wfqueue.h